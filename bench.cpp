@@ -0,0 +1,263 @@
+/*   bench.cpp - Render and flush microbenchmarks, build with BENCHMARK   */
+
+#if defined(BENCHMARK)
+
+#include <Arduino.h>
+#include "display.h"
+#include "oled.h"
+#include "bench.h"
+#include "fuelCalculator.h"
+#include "pitOptimizer.h"
+#include "fuelMeter.h"
+
+// 64 bit, 32 bits of ns wrap after 4.3 s and a flush run takes longer on target
+#if defined(ARDUINO)
+static uint64_t bench_now_ns(void) {
+    return micros() * 1000ULL;
+}
+#else
+#include <chrono>
+static uint64_t bench_now_ns(void) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+#endif
+
+static uint8_t frame[ROWS][COLUMNS];
+static OLED bench_oled(0x3C, 0);
+static bool first_result;
+// Value size of the size dependent results, nullptr for the rest
+static const char *size_name;
+
+static const FontSize bench_sizes[] = {FontSize::Single, FontSize::Double, FontSize::Triple, FontSize::Quadro};
+static const char *const bench_size_names[] = {"SINGLE", "DOUBLE", "TRIPLE", "QUADRO"};
+
+static void report(Print &out, const char *name, const char *arg, uint64_t elapsed_ns, uint32_t calls, uint32_t frames, uint32_t i2c_bytes, uint32_t bus_us) {
+    out.print(first_result ? "\n    " : ",\n    ");
+    out.print("{\"name\": \"");
+    out.print(name);
+    out.print("\", \"arg\": \"");
+    out.print(arg);
+    if (size_name != nullptr) {
+        out.print("\", \"size\": \"");
+        out.print(size_name);
+    }
+    out.print("\", \"ns_per_call\": ");
+    out.print(static_cast<unsigned long>(elapsed_ns / calls));
+    if (frames > 0) {
+        out.print(", \"i2c_bytes_per_frame\": ");
+        out.print(static_cast<unsigned long>(i2c_bytes / frames));
+        out.print(", \"bus_us_per_frame\": ");
+        out.print(static_cast<unsigned long>(bus_us / frames));
+    }
+    out.print("}");
+    first_result = false;
+}
+
+/* Alternate between two values so every call renders a change */
+static void bench_value(Print &out, FontSize size, const char *a, const char *b) {
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        print_value(frame[0], (i & 1) ? b : a, size);
+    }
+    report(out, "print_value", a, bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+    clear_dirty();
+}
+
+static void bench_header(Print &out, const char *a, const char *b) {
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        print_header(frame[0], (i & 1) ? b : a);
+    }
+    report(out, "print_header", a, bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+    clear_dirty();
+}
+
+/*
+ * The per-byte read-modify-write renderer that put_glyph replaced, kept
+ * for comparison. Column-major fonts on a word framebuffer, every byte is
+ * shifted out of its column and masked into its word. Digits only.
+ */
+static uint32_t ref_frame[ROWS * COLUMNS / 4];
+static uint8_t ref_row;
+static uint8_t ref_col;
+
+static const font0507 ref_nums0507[] = {n0507_0, n0507_1, n0507_2, n0507_3, n0507_4, n0507_5, n0507_6, n0507_7, n0507_8, n0507_9};
+static const font1014 ref_nums1014[] = {n1014_0, n1014_1, n1014_2, n1014_3, n1014_4, n1014_5, n1014_6, n1014_7, n1014_8, n1014_9};
+static const font1521 ref_nums1521[] = {n1521_0, n1521_1, n1521_2, n1521_3, n1521_4, n1521_5, n1521_6, n1521_7, n1521_8, n1521_9};
+static const font2028 ref_nums2028[] = {n2028_0, n2028_1, n2028_2, n2028_3, n2028_4, n2028_5, n2028_6, n2028_7, n2028_8, n2028_9};
+
+static void ref_put_byte(uint8_t row, uint8_t byte) {
+    uint8_t shift = ref_col%4 * 8;
+    uint32_t mask = 0xffUL << shift;
+    uint32_t *word = &ref_frame[ref_col/4 + row*(COLUMNS/4)];
+
+    if(((*word & mask) >> shift) != byte) {
+        *word = (*word & ~mask) | (static_cast<uint32_t>(byte) << shift);
+        mark_dirty(row, ref_col, ref_col);
+    }
+}
+
+/* A glyph of width columns and pages rows, followed by pages blank columns */
+template <typename F>
+static void ref_put_font(const F &ch, uint8_t width, uint8_t pages) {
+    uint8_t orig_col = ref_col;
+
+    for (uint8_t h = 0; h < pages && ref_row + h < ROWS; ++h) {
+        ref_col = orig_col;
+        for (uint8_t i = 0; i < width + pages && ref_col < COLUMNS; ++i) {
+            ref_put_byte(ref_row + h, i < width ? (ch.col[i] >> (h*8)) & 0xff : 0x00);
+            ref_col++;
+        }
+    }
+}
+
+static void ref_print_font(FontSize size, const char *text) {
+    for (; *text != '\0'; ++text) {
+        uint8_t digit = *text - '0';
+        switch(size) {
+            case FontSize::Single:
+                ref_put_font(ref_nums0507[digit], 5, 1);
+                break;
+            case FontSize::Double:
+                ref_put_font(ref_nums1014[digit], 10, 2);
+                break;
+            case FontSize::Triple:
+                ref_put_font(ref_nums1521[digit], 15, 3);
+                break;
+            case FontSize::Quadro:
+                ref_put_font(ref_nums2028[digit], 20, 4);
+                break;
+        }
+    }
+}
+
+/* The same digits through both renderers, from the top row so every size fits */
+static void bench_font(Print &out, FontSize size, const char *a, const char *b) {
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        set_cursor(HEADER_START_ROW, 0);
+        print_font(frame[0], size, (i & 1) ? b : a);
+    }
+    report(out, "print_font", a, bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+    clear_dirty();
+
+    start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        ref_row = HEADER_START_ROW;
+        ref_col = 0;
+        ref_print_font(size, (i & 1) ? b : a);
+    }
+    report(out, "print_font_rmw", a, bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+    clear_dirty();
+}
+
+static void bench_unit(Print &out, FontSize size) {
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        print_unit(frame[0], (i & 1) ? UNIT_lL : UNIT_l, size);
+    }
+    report(out, "print_unit", "l", bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+    clear_dirty();
+}
+
+static void bench_set_value(Print &out, int32_t value, uint8_t decimals, const char *arg) {
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        bench_oled.set_value(value + (i & 1), decimals);
+    }
+    report(out, "set_value", arg, bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+}
+
+/* Render and send one value change per frame */
+static void bench_flush(Print &out, const char *a, const char *b) {
+    uint64_t elapsed = 0;
+    uint32_t bus_us = 0;
+    uint64_t start;
+    uint32_t start_us;
+
+    bench_oled.flush();
+    bench_oled.reset_stats();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        bench_oled.set_value((i & 1) ? b : a);
+        start_us = micros();
+        start = bench_now_ns();
+        bench_oled.flush();
+        elapsed += bench_now_ns() - start;
+        // Virtual bus time on the host, wall time on target
+        bus_us += micros() - start_us;
+    }
+    report(out, "update_ssd1306", a, elapsed, BENCH_ITERATIONS, bench_oled.get_stats().frames, bench_oled.get_stats().bytes, bus_us);
+}
+
+/* The float calculator the integer one replaced, for comparison */
+static int32_t float_fuel_needed(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint8_t fuel_consumption) {
+    float laps = race_length * 60 / static_cast<float>(laptime);
+    if (warmup != 0U) {
+        laps += cWarmUpLapMultiplier;
+    }
+    return static_cast<int32_t>(static_cast<int>(ceil(laps)) * fuel_consumption);
+}
+
+/* Sweep the laptime range so divisions aren't all the same */
+static void bench_calculator(Print &out, const char *name, int32_t (*calc)(uint8_t, uint8_t, uint8_t, uint8_t)) {
+    volatile int32_t sink = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        sink = sink + calc(i & 1, 45, cMIN_LAPTIME + i % (cMAX_LAPTIME - cMIN_LAPTIME + 1), 30);
+    }
+    report(out, name, "45 min", bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+}
+
+/* Long race, small tank and a cheap pit lane, the most stops to consider */
+static void bench_pit_stops(Print &out) {
+    volatile uint32_t sink = 0;
+    pit_plan plan;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        plan_pit_stops(i & 1, 120, cMIN_LAPTIME + i % (cMAX_LAPTIME - cMIN_LAPTIME + 1),
+                       cMIN_FUEL_CUNSUMPTION + i % (cMAX_FUEL_CUNSUMPTION - cMIN_FUEL_CUNSUMPTION + 1), 60, cMIN_PIT_LOSS, plan);
+        sink = sink + plan.cost_ms;
+    }
+    report(out, "plan_pit_stops", "120 min", bench_now_ns() - start, BENCH_ITERATIONS, 0, 0, 0);
+}
+
+void run_benchmarks(Print &out) {
+    first_result = true;
+    memset(frame, 0, sizeof(frame));
+    init_display(COLUMNS, ROWS);
+
+    out.print("{\"iterations\": ");
+    out.print(BENCH_ITERATIONS);
+    out.print(", \"calc_table_bytes\": ");
+    out.print(static_cast<unsigned long>(calc_table_bytes()));
+    out.print(", \"results\": [");
+    size_name = nullptr;
+    bench_header(out, "FUEL CONSUMPTION?", "LAPTIME?");
+    bench_calculator(out, "calculate_fuel_needed", calculate_fuel_needed);
+    bench_calculator(out, "float_fuel_needed", float_fuel_needed);
+    bench_pit_stops(out);
+
+    // One binary covers every value size now that it is chosen at runtime
+    bench_oled.start();
+    for (uint8_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); ++i) {
+        size_name = bench_size_names[i];
+        memset(frame, 0, sizeof(frame));
+        memset(ref_frame, 0, sizeof(ref_frame));
+        bench_font(out, bench_sizes[i], "123456", "654321");
+        bench_value(out, bench_sizes[i], "123456", "654321");
+        bench_value(out, bench_sizes[i], "1:40", "1:41");
+        bench_value(out, bench_sizes[i], "YES", "NO");
+        bench_unit(out, bench_sizes[i]);
+
+        bench_oled.set_value_size(bench_sizes[i]);
+        bench_set_value(out, 1234, 1, "123.4");
+        bench_set_value(out, 140, 2, "1.40");
+        bench_flush(out, "123456", "654321");
+        bench_flush(out, "1:40", "1:41");
+        bench_flush(out, "YES", "NO");
+    }
+    out.println("\n]}");
+}
+
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+class Print;
+
+#ifndef BENCH_ITERATIONS
+#if defined(ARDUINO)
+#define BENCH_ITERATIONS    200
+#else
+#define BENCH_ITERATIONS    20000
+#endif
+#endif
+
+void run_benchmarks(Print &out);
@@ -6,23 +6,52 @@
 #include <inttypes.h>
 #include "display.h"
 
+/* Font tables live in flash, AVR needs the _P variants to read them */
+#if defined(__AVR__)
+#define font_memcpy memcpy_P
+#define font_memcmp memcmp_P
+#else
+#define font_memcpy memcpy
+#define font_memcmp memcmp
+#endif
+
+#ifndef FONT_FLASH_BUDGET
+#define FONT_FLASH_BUDGET   8192
+#endif
+
 static uint8_t cursor_col;
 static uint8_t cursor_row;
 static uint8_t num_rows;
 static uint8_t num_cols;
-
-const struct font0507 ns0507[] = {n0507_0, n0507_1, n0507_2, n0507_3, n0507_4, n0507_5, n0507_6, n0507_7, n0507_8, n0507_9};
-const struct font0507 cs0507_up[] = {c0507_A, c0507_B, c0507_C, c0507_D, c0507_E, c0507_F, c0507_G, c0507_H, c0507_I, c0507_J, c0507_K, c0507_L, c0507_M, c0507_N, c0507_O, c0507_P, c0507_Q, c0507_R, c0507_S, c0507_T, c0507_U, c0507_V, c0507_W, c0507_X, c0507_Y, c0507_Z, c0507_UNKN};
-const struct font0507 cs0507_low[] = {c0507_a, c0507_b, c0507_c, c0507_d, c0507_e, c0507_f, c0507_g, c0507_h, c0507_i, c0507_j, c0507_k, c0507_l, c0507_m, c0507_n, c0507_o, c0507_p, c0507_q, c0507_r, c0507_s, c0507_t, c0507_u, c0507_v, c0507_w, c0507_x, c0507_y, c0507_z, c0507_UNKN};
-const struct font0507 s0507[] = {c0507_UNKN, s0507_1, s0507_2, s0507_3, s0507_4, s0507_5, s0507_6, s0507_7, s0507_8, s0507_9, s0507_10, s0507_11, s0507_12, s0507_13, s0507_14, s0507_15};
-const struct font1014 ns1014[] = {n1014_0, n1014_1, n1014_2, n1014_3, n1014_4, n1014_5, n1014_6, n1014_7, n1014_8, n1014_9};
-const struct font1014 s1014[] = {c1014_UNKN, s1014_1, s1014_2, s1014_3, s1014_4};
-const struct font1521 ns1521[] = {n1521_0, n1521_1, n1521_2, n1521_3, n1521_4, n1521_5, n1521_6, n1521_7, n1521_8, n1521_9};
-const struct font1521 cs1521_up[] = {c1521_E, c1521_N, c1521_O, c1521_S, c1521_Y, c1521_UNKN};
-const struct font1521 s1521[] = {c1521_UNKN, s1521_1, s1521_2, s1521_3, s1521_4, s1521_5};
-const struct font2028 ns2028[] = {n2028_0, n2028_1, n2028_2, n2028_3, n2028_4, n2028_5, n2028_6, n2028_7, n2028_8, n2028_9};
-const struct font2028 cs2028_up[] = {c2028_E, c2028_N, c2028_O, c2028_S, c2028_Y, c2028_UNKN};
-const struct font2028 s2028[] = {c2028_UNKN, s2028_1, s2028_2, s2028_3, s2028_4};
+static uint8_t dirty_first[MAX_ROWS];
+static uint8_t dirty_last[MAX_ROWS];
+// Padded value string in each cell of the value field, as last drawn
+static const uint8_t *value_data;
+static FontSize value_size;
+static char value_cells[VALUE_MAX_CELLS + 1];
+
+constexpr glyph0507 ns0507[] PROGMEM = {G0507(n0507_0), G0507(n0507_1), G0507(n0507_2), G0507(n0507_3), G0507(n0507_4), G0507(n0507_5), G0507(n0507_6), G0507(n0507_7), G0507(n0507_8), G0507(n0507_9)};
+constexpr glyph0507 cs0507_up[] PROGMEM = {G0507(c0507_A), G0507(c0507_B), G0507(c0507_C), G0507(c0507_D), G0507(c0507_E), G0507(c0507_F), G0507(c0507_G), G0507(c0507_H), G0507(c0507_I), G0507(c0507_J), G0507(c0507_K), G0507(c0507_L), G0507(c0507_M), G0507(c0507_N), G0507(c0507_O), G0507(c0507_P), G0507(c0507_Q), G0507(c0507_R), G0507(c0507_S), G0507(c0507_T), G0507(c0507_U), G0507(c0507_V), G0507(c0507_W), G0507(c0507_X), G0507(c0507_Y), G0507(c0507_Z), G0507(c0507_UNKN)};
+constexpr glyph0507 cs0507_low[] PROGMEM = {G0507(c0507_a), G0507(c0507_b), G0507(c0507_c), G0507(c0507_d), G0507(c0507_e), G0507(c0507_f), G0507(c0507_g), G0507(c0507_h), G0507(c0507_i), G0507(c0507_j), G0507(c0507_k), G0507(c0507_l), G0507(c0507_m), G0507(c0507_n), G0507(c0507_o), G0507(c0507_p), G0507(c0507_q), G0507(c0507_r), G0507(c0507_s), G0507(c0507_t), G0507(c0507_u), G0507(c0507_v), G0507(c0507_w), G0507(c0507_x), G0507(c0507_y), G0507(c0507_z), G0507(c0507_UNKN)};
+constexpr glyph0507 s0507[] PROGMEM = {G0507(c0507_UNKN), G0507(s0507_1), G0507(s0507_2), G0507(s0507_3), G0507(s0507_4), G0507(s0507_5), G0507(s0507_6), G0507(s0507_7), G0507(s0507_8), G0507(s0507_9), G0507(s0507_10), G0507(s0507_11), G0507(s0507_12), G0507(s0507_13), G0507(s0507_14), G0507(s0507_15)};
+constexpr glyph1014 ns1014[] PROGMEM = {G1014(n1014_0), G1014(n1014_1), G1014(n1014_2), G1014(n1014_3), G1014(n1014_4), G1014(n1014_5), G1014(n1014_6), G1014(n1014_7), G1014(n1014_8), G1014(n1014_9)};
+constexpr glyph1014 s1014[] PROGMEM = {G1014(c1014_UNKN), G1014(s1014_1), G1014(s1014_2), G1014(s1014_3), G1014(s1014_4)};
+constexpr glyph1521 ns1521[] PROGMEM = {G1521(n1521_0), G1521(n1521_1), G1521(n1521_2), G1521(n1521_3), G1521(n1521_4), G1521(n1521_5), G1521(n1521_6), G1521(n1521_7), G1521(n1521_8), G1521(n1521_9)};
+constexpr glyph1521 cs1521_up[] PROGMEM = {G1521(c1521_E), G1521(c1521_N), G1521(c1521_O), G1521(c1521_S), G1521(c1521_Y), G1521(c1521_UNKN)};
+constexpr glyph1521 s1521[] PROGMEM = {G1521(c1521_UNKN), G1521(s1521_1), G1521(s1521_2), G1521(s1521_3), G1521(s1521_4), G1521(s1521_5)};
+constexpr glyph2028 ns2028[] PROGMEM = {G2028(n2028_0), G2028(n2028_1), G2028(n2028_2), G2028(n2028_3), G2028(n2028_4), G2028(n2028_5), G2028(n2028_6), G2028(n2028_7), G2028(n2028_8), G2028(n2028_9)};
+constexpr glyph2028 cs2028_up[] PROGMEM = {G2028(c2028_E), G2028(c2028_N), G2028(c2028_O), G2028(c2028_S), G2028(c2028_Y), G2028(c2028_UNKN)};
+constexpr glyph2028 s2028[] PROGMEM = {G2028(c2028_UNKN), G2028(s2028_1), G2028(s2028_2), G2028(s2028_3), G2028(s2028_4)};
+
+#define FONT_TABLES(X) \
+    X(ns0507) X(cs0507_up) X(cs0507_low) X(s0507) \
+    X(ns1014) X(s1014) \
+    X(ns1521) X(cs1521_up) X(s1521) \
+    X(ns2028) X(cs2028_up) X(s2028)
+
+#define FONT_TABLE_SIZE(table) + sizeof(table)
+static constexpr size_t font_flash_bytes = 0 FONT_TABLES(FONT_TABLE_SIZE);
+static_assert(font_flash_bytes <= FONT_FLASH_BUDGET, "Font tables exceed FONT_FLASH_BUDGET");
 
 struct unit_struct unit_details[LAST_UNIT + 1] = {
     {"-",    "kPa", 0},
@@ -55,6 +84,58 @@ void init_display(uint8_t cols, uint8_t rows) {
     num_rows = rows;
     cursor_col = 0;
     cursor_row = 0;
+    clear_dirty();
+    forget_value();
+}
+
+/* Mark columns of a row changed */
+void mark_dirty(uint8_t row, uint8_t first_col, uint8_t last_col) {
+    if(row >= num_rows) {
+        return;
+    }
+
+    if(first_col < dirty_first[row]) {
+        dirty_first[row] = first_col;
+    }
+    if(last_col > dirty_last[row] || dirty_last[row] == 0xff) {
+        dirty_last[row] = last_col;
+    }
+}
+
+/* Mark the whole display changed */
+void mark_all_dirty(void) {
+    for (int row = 0; row < num_rows; ++row) {
+        mark_dirty(row, 0, num_cols-1);
+    }
+}
+
+/* Get changed column range of a row, returns 0 if row is clean */
+int get_dirty(uint8_t row, uint8_t *first_col, uint8_t *last_col) {
+    if(row >= num_rows || dirty_last[row] == 0xff) {
+        return 0;
+    }
+
+    *first_col = dirty_first[row];
+    *last_col = dirty_last[row];
+
+    return 1;
+}
+
+/* Check if any row has changed */
+int is_dirty(void) {
+    for (int row = 0; row < num_rows; ++row) {
+        if(dirty_last[row] != 0xff) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Forget all changes */
+void clear_dirty(void) {
+    memset(dirty_first, 0xff, sizeof(dirty_first));
+    memset(dirty_last, 0xff, sizeof(dirty_last));
 }
 
 /* Set cursor */
@@ -96,348 +177,303 @@ int set_col(uint8_t col) {
     return cursor_col == col;
 }
 
-/* Write a character to data buffer */
-int put_font0507(uint32_t *data, struct font0507 ch) {
-    uint32_t mask;
-    uint32_t word;
-    uint8_t shift;
+/* Set one column byte of a row */
+void put_column(uint8_t *data, uint8_t row, uint8_t col, uint8_t bits) {
+    uint8_t *dst;
 
-    if(cursor_row >= num_rows) {
-        return 0;
+    if(row >= num_rows || col >= num_cols) {
+        return;
     }
 
-    for (int i = 0; i < 5+1; ++i) {
-        if(cursor_col >= num_cols) {
-            return 0;
-        }
-
-        shift = cursor_col%4 * 8;
-        mask = 0xff << shift;
-        word = data[cursor_col/4 + cursor_row*(num_cols/4)];
-
-        // Empty column after a character
-        if(i == 5) {
-            data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask);
-        } else {
-            data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask) | (ch.col[i] << (shift));
-        }
-
-        cursor_col++;
+    dst = &data[row*num_cols + col];
+    if(*dst != bits) {
+        *dst = bits;
+        mark_dirty(row, col, col);
     }
-    
-    return 1;
 }
 
-/* Write a character to data buffer in double size */
-int put_font1014(uint32_t *data, struct font1014 ch) {
-    uint32_t mask;
-    uint32_t word;
-    uint8_t shift;
-
-    uint8_t orig_col = cursor_col;
-    uint8_t orig_row = cursor_row;
-    for (int h = 0; h < 2; ++h) {
-        if(cursor_row >= num_rows) {
-            cursor_row = orig_row;
-            return 0;
-        }
-
-        cursor_col = orig_col;
-        
-        for (int i = 0; i < 10+2; ++i) {
-            if(cursor_col >= num_cols) {
-                break;
-            }
+/* Copy a glyph page by page followed by its blank spacer columns */
+template <uint8_t W, uint8_t H>
+static int put_glyph(uint8_t *data, const glyph<W, H> *ch) {
+    uint8_t width = W;
+    uint8_t spacer = H;
+    uint8_t pages = H;
+    uint8_t *dst;
+    uint8_t changed;
+
+    if(cursor_col + width > num_cols) {
+        width = num_cols - cursor_col;
+        spacer = 0;
+    } else if(cursor_col + width + spacer > num_cols) {
+        spacer = num_cols - cursor_col - width;
+    }
 
-            shift = cursor_col%4 * 8;
-            mask = 0xff << shift;
-            word = data[cursor_col/4 + cursor_row*(num_cols/4)];
+    if(cursor_row + pages > num_rows) {
+        pages = num_rows - cursor_row;
+    }
 
-            if(i >= 10) {
-                data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask);
-            } else {
-                data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask) | (((ch.col[i] >> (h*8)) & 0x000000ff) << (shift));
-            }
-            cursor_col++;
+    for (int h = 0; h < pages; ++h) {
+        dst = &data[(cursor_row + h)*num_cols + cursor_col];
+        changed = font_memcmp(dst, &ch->col[h*W], width) != 0;
+        for (int i = 0; i < spacer; ++i) {
+            changed |= dst[width + i];
+        }
+        if(changed) {
+            font_memcpy(dst, &ch->col[h*W], width);
+            memset(dst + width, 0x00, spacer);
+            mark_dirty(cursor_row + h, cursor_col, cursor_col + width + spacer - 1);
         }
-        cursor_row++;
     }
-    cursor_row = orig_row;
+    cursor_col += width + spacer;
 
-    return 1;
+    return width == W && pages == H;
 }
 
-/* Write a character to data buffer in triple size */
-int put_font1521(uint32_t *data, struct font1521 ch) {
-    uint32_t mask;
-    uint32_t word;
-    uint8_t shift;
-
-    uint8_t orig_col = cursor_col;
-    uint8_t orig_row = cursor_row;
-    for (int h = 0; h < 3; ++h) {
-        if(cursor_row >= num_rows) {
-            cursor_row = orig_row;
-            return 0;
-        }
-
-        cursor_col = orig_col;
-        
-        for (int i = 0; i < 15+3; ++i) {
-            if(cursor_col >= num_cols) {
-                break;
-            }
+/* Write a character to data buffer */
+int put_font0507(uint8_t *data, const glyph0507 *ch) {
+    if(cursor_row >= num_rows || cursor_col >= num_cols) {
+        return 0;
+    }
 
-            shift = cursor_col%4 * 8;
-            mask = 0xff << shift;
-            word = data[cursor_col/4 + cursor_row*(num_cols/4)];
+    return put_glyph(data, ch);
+}
 
-            if(i >= 15) {
-                data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask);
-            } else {
-                data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask) | (((ch.col[i] >> (h*8)) & 0x000000ff) << (shift));
-            }
-            cursor_col++;
-        }
-        cursor_row++;
+/* Write a character to data buffer in double size */
+int put_font1014(uint8_t *data, const glyph1014 *ch) {
+    if(cursor_row >= num_rows || cursor_col >= num_cols) {
+        return 0;
     }
-    cursor_row = orig_row;
 
-    return 1;
+    return put_glyph(data, ch);
 }
 
-/* Write a character to data buffer in quadruple size */
-int put_font2028(uint32_t *data, struct font2028 ch) {
-    uint32_t mask;
-    uint32_t word;
-    uint8_t shift;
-
-    uint8_t orig_col = cursor_col;
-    uint8_t orig_row = cursor_row;
-    for (int h = 0; h < 4; ++h) {
-        if(cursor_row >= num_rows) {
-            cursor_row = orig_row;
-            return 0;
-        }
-
-        cursor_col = orig_col;
-        
-        for (int i = 0; i < 20+4; ++i) {
-            if(cursor_col >= num_cols) {
-                break;
-            }
+/* Write a character to data buffer in triple size */
+int put_font1521(uint8_t *data, const glyph1521 *ch) {
+    if(cursor_row >= num_rows || cursor_col >= num_cols) {
+        return 0;
+    }
 
-            shift = cursor_col%4 * 8;
-            mask = 0xff << shift;
-            word = data[cursor_col/4 + cursor_row*(num_cols/4)];
+    return put_glyph(data, ch);
+}
 
-            if(i >= 20) {
-                data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask);
-            } else {
-                data[cursor_col/4 + cursor_row*(num_cols/4)] = (word & ~mask) | (((ch.col[i] >> (h*8)) & 0x000000ff) << (shift));
-            }
-            cursor_col++;
-        }
-        cursor_row++;
+/* Write a character to data buffer in quadruple size */
+int put_font2028(uint8_t *data, const glyph2028 *ch) {
+    if(cursor_row >= num_rows || cursor_col >= num_cols) {
+        return 0;
     }
-    cursor_row = orig_row;
 
-    return 1;
+    return put_glyph(data, ch);
 }
 
-/* Print text */
-void print_font0507(uint32_t *data, const char *text) {
-    while(*text != '\0') {
-        switch(*text) {
+/* Glyph of a character for each font size */
+template <FontSize S>
+struct font_glyph;
+
+template <>
+struct font_glyph<FontSize::Single> {
+    static const glyph0507 *get(char c) {
+        switch(c) {
             case ' ':
-                put_font0507(data, s0507[1]);
-                break;
+                return &s0507[1];
             case '.':
-                put_font0507(data, s0507[2]);
-                break;
+                return &s0507[2];
             case ',':
-                put_font0507(data, s0507[3]);
-                break;
+                return &s0507[3];
             case ':':
-                put_font0507(data, s0507[4]);
-                break;
+                return &s0507[4];
             case ';':
-                put_font0507(data, s0507[5]);
-                break;
+                return &s0507[5];
             case '-':
-                put_font0507(data, s0507[6]);
-                break;
+                return &s0507[6];
             case '+':
-                put_font0507(data, s0507[7]);
-                break;
+                return &s0507[7];
             case '_':
-                put_font0507(data, s0507[8]);
-                break;
+                return &s0507[8];
             case '%':
-                put_font0507(data, s0507[11]);
-                break;
+                return &s0507[11];
             case '/':
-                put_font0507(data, s0507[12]);
-                break;
+                return &s0507[12];
             case '#':
-                put_font0507(data, s0507[10]);
-                break;
+                return &s0507[10];
             case '?':
-                put_font0507(data, s0507[13]);
-                break;
+                return &s0507[13];
             case '>':
-                put_font0507(data, s0507[14]);
-                break;
+                return &s0507[14];
             case '<':
-                put_font0507(data, s0507[15]);
-                break;
+                return &s0507[15];
             default:
-                if(*text >= '0' && *text <= '9') {
-                    put_font0507(data, ns0507[*text-'0']);
-                } else if(*text >= 'A' && *text <= 'Z') {
-                    put_font0507(data, C0507(*text));
-                } else if(*text >= 'a' && *text <= 'z') {
-                    put_font0507(data, C0507(*text));
+                if(c >= '0' && c <= '9') {
+                    return &ns0507[c-'0'];
+                } else if(c >= 'A' && c <= 'Z') {
+                    return C0507(c);
+                } else if(c >= 'a' && c <= 'z') {
+                    return C0507(c);
                 } else {
-                    put_font0507(data, s0507[0]);
+                    return &s0507[0];
                 }
-                break;
         }
-        text++;
     }
-}
+};
 
-/* Print text in double size */
-void print_font1014(uint32_t *data, const char *text) {
-    while(*text != '\0') {
-        switch(*text) {
+template <>
+struct font_glyph<FontSize::Double> {
+    static const glyph1014 *get(char c) {
+        switch(c) {
             case ' ':
-                put_font1014(data, s1014[1]);
-                break;
+                return &s1014[1];
             case '.':
-                put_font1014(data, s1014[2]);
-                break;
+                return &s1014[2];
             case ',':
-                put_font1014(data, s1014[3]);
-                break;
+                return &s1014[3];
             case '-':
-                put_font1014(data, s1014[4]);
-                break;
+                return &s1014[4];
             default:
-                if(*text >= '0' && *text <= '9') {
-                    put_font1014(data, ns1014[*text-'0']);
-                } else if(*text >= 'A' && *text <= 'Z') {
-                    put_font1014(data, s1014[0]);
-                } else if(*text >= 'a' && *text <= 'z') {
-                    put_font1014(data, s1014[0]);
+                if(c >= '0' && c <= '9') {
+                    return &ns1014[c-'0'];
+                } else if(c >= 'A' && c <= 'Z') {
+                    return &s1014[0];
+                } else if(c >= 'a' && c <= 'z') {
+                    return &s1014[0];
                 } else {
-                    put_font1014(data, s1014[0]);
+                    return &s1014[0];
                 }
-                break;
         }
-        text++;
     }
-}
+};
 
-/* Print text in triple size */
-void print_font1521(uint32_t *data, const char *text) {
-    while(*text != '\0') {
-        switch(*text) {
+template <>
+struct font_glyph<FontSize::Triple> {
+    static const glyph1521 *get(char c) {
+        switch(c) {
             case ' ':
-                put_font1521(data, s1521[1]);
-                break;
+                return &s1521[1];
             case '.':
-                put_font1521(data, s1521[2]);
-                break;
+                return &s1521[2];
             case ',':
-                put_font1521(data, s1521[3]);
-                break;
+                return &s1521[3];
             case ':':
-                put_font1521(data, s1521[4]);
-                break;
+                return &s1521[4];
             case '-':
-                put_font1521(data, s1521[5]);
-                break;
+                return &s1521[5];
             case 'E':
-                put_font1521(data, cs1521_up[0]);
-                break;
+                return &cs1521_up[0];
             case 'N':
-                put_font1521(data, cs1521_up[1]);
-                break;
+                return &cs1521_up[1];
             case 'O':
-                put_font1521(data, cs1521_up[2]);
-                break;
+                return &cs1521_up[2];
             case 'S':
-                put_font1521(data, cs1521_up[3]);
-                break;
+                return &cs1521_up[3];
             case 'Y':
-                put_font1521(data, cs1521_up[4]);
-                break;
+                return &cs1521_up[4];
             default:
-                if(*text >= '0' && *text <= '9') {
-                    put_font1521(data, ns1521[*text-'0']);
-                } else if(*text >= 'A' && *text <= 'Z') {
-                    put_font1521(data, s1521[0]);
-                } else if(*text >= 'a' && *text <= 'z') {
-                    put_font1521(data, s1521[0]);
+                if(c >= '0' && c <= '9') {
+                    return &ns1521[c-'0'];
+                } else if(c >= 'A' && c <= 'Z') {
+                    return &s1521[0];
+                } else if(c >= 'a' && c <= 'z') {
+                    return &s1521[0];
                 } else {
-                    put_font1521(data, s1521[0]);
+                    return &s1521[0];
                 }
-                break;
         }
-        text++;
     }
-}
+};
 
-/* Print text in quadruple size */
-void print_font2028(uint32_t *data, const char *text) {
-    while(*text != '\0') {
-        switch(*text) {
+template <>
+struct font_glyph<FontSize::Quadro> {
+    static const glyph2028 *get(char c) {
+        switch(c) {
             case ' ':
-                put_font2028(data, s2028[1]);
-                break;
+                return &s2028[1];
             case '.':
-                put_font2028(data, s2028[2]);
-                break;
+                return &s2028[2];
             case ',':
-                put_font2028(data, s2028[3]);
-                break;
+                return &s2028[3];
             case '-':
-                put_font2028(data, s2028[4]);
-                break;
+                return &s2028[4];
             case 'E':
-                put_font2028(data, cs2028_up[0]);
-                break;
+                return &cs2028_up[0];
             case 'N':
-                put_font2028(data, cs2028_up[1]);
-                break;
+                return &cs2028_up[1];
             case 'O':
-                put_font2028(data, cs2028_up[2]);
-                break;
+                return &cs2028_up[2];
             case 'S':
-                put_font2028(data, cs2028_up[3]);
-                break;
+                return &cs2028_up[3];
             case 'Y':
-                put_font2028(data, cs2028_up[4]);
-                break;
+                return &cs2028_up[4];
             default:
-                if(*text >= '0' && *text <= '9') {
-                    put_font2028(data, ns2028[*text-'0']);
-                } else if(*text >= 'A' && *text <= 'Z') {
-                    put_font2028(data, s2028[0]);
-                } else if(*text >= 'a' && *text <= 'z') {
-                    put_font2028(data, s2028[0]);
+                if(c >= '0' && c <= '9') {
+                    return &ns2028[c-'0'];
+                } else if(c >= 'A' && c <= 'Z') {
+                    return &s2028[0];
+                } else if(c >= 'a' && c <= 'z') {
+                    return &s2028[0];
                 } else {
-                    put_font2028(data, s2028[0]);
+                    return &s2028[0];
                 }
-                break;
         }
+    }
+};
+
+/* Write a character of the given size to data buffer */
+template <FontSize S>
+static int put_char(uint8_t *data, char c) {
+    if(cursor_row >= num_rows || cursor_col >= num_cols) {
+        return 0;
+    }
+
+    return put_glyph(data, font_glyph<S>::get(c));
+}
+
+/* Print text, the inner loop is specialized for every size */
+template <FontSize S>
+static void print_text(uint8_t *data, const char *text) {
+    while(*text != '\0') {
+        put_char<S>(data, *text);
         text++;
     }
 }
 
+/* Print text */
+void print_font0507(uint8_t *data, const char *text) {
+    print_text<FontSize::Single>(data, text);
+}
+
+/* Print text in double size */
+void print_font1014(uint8_t *data, const char *text) {
+    print_text<FontSize::Double>(data, text);
+}
+
+/* Print text in triple size */
+void print_font1521(uint8_t *data, const char *text) {
+    print_text<FontSize::Triple>(data, text);
+}
+
+/* Print text in quadruple size */
+void print_font2028(uint8_t *data, const char *text) {
+    print_text<FontSize::Quadro>(data, text);
+}
+
+/* Print text in the given size */
+void print_font(uint8_t *data, FontSize size, const char *text) {
+    switch(size) {
+        case FontSize::Single:
+            print_font0507(data, text);
+            break;
+        case FontSize::Double:
+            print_font1014(data, text);
+            break;
+        case FontSize::Triple:
+            print_font1521(data, text);
+            break;
+        case FontSize::Quadro:
+            print_font2028(data, text);
+            break;
+    }
+}
+
 /* Print header */
-void print_header(uint32_t *data, const char *text, Alignment alignment) {
+void print_header(uint8_t *data, const char *text, Alignment alignment) {
     uint8_t len = strlen(text);
     uint8_t left_fill = 0;
     uint8_t right_fill = 0;
@@ -456,7 +492,7 @@ void print_header(uint32_t *data, const char *text, Alignment alignment) {
 
     // Put left fillers
     for (int i = 0; i < right_fill; ++i) {
-        put_font0507(data, s0507[1]);
+        put_font0507(data, &s0507[1]);
     }
     print_font0507(data, text);
 
@@ -468,117 +504,163 @@ void print_header(uint32_t *data, const char *text, Alignment alignment) {
 
     // Put right fillers
     for (int i = 0; i < left_fill; ++i) {
-        put_font0507(data, s0507[1]);
+        put_font0507(data, &s0507[1]);
     }
 }
 
-/* Value in double size */
-void print_value(uint32_t *data, const char *text) {
-    // cprintf("Value: %s\n", text);
-
-#ifdef SINGLE
-    uint8_t len = strlen(text);
-
-    if(len > 18) {
-        return;
-    }
-
-    set_cursor(VALUE_START_ROW, 0);
-
-    // Put fillers
-    for (int i = 0; i < 18-len; ++i) {
-        put_font0507(data, s0507[1]);
-    }
-
-    print_font0507(data, text);
-#endif
-#ifdef DOUBLE
-    uint8_t len = strlen(text);
-
-    if(len > 9) {
-        return;
-    }
-
-    set_cursor(VALUE_START_ROW, 0);
+/* Value field of each size, characters that fit before the unit and first column */
+struct value_layout {
+    uint8_t len;
+    uint8_t col;
+};
 
-    // Put fillers
-    for (int i = 0; i < 9-len; ++i) {
-        put_font1014(data, s1014[1]);
-    }
+static const struct value_layout value_layouts[] = {
+    {VALUE_MAX_CELLS, 0},
+    {9, 0},
+    {6, 2},
+    {4, 14}
+};
 
-    print_font1014(data, text);
-#endif
-#ifdef TRIPLE
+/* Right aligned value, only the cells whose character changed are drawn */
+template <FontSize S>
+static void print_value_as(uint8_t *data, const char *text) {
+    const struct value_layout &layout = value_layouts[static_cast<uint8_t>(S) - 1];
     uint8_t len = strlen(text);
+    uint8_t fill;
+    bool known;
+    char ch;
 
-    if(len > 6) {
+    if(len > layout.len) {
         return;
     }
 
-    set_cursor(VALUE_START_ROW, 2);
-
-    // Put fillers
-    for (int i = 0; i < 6-len; ++i) {
-        put_font1521(data, s1521[1]);
-    }
-
-    print_font1521(data, text);
-#endif
-#ifdef QUADRO
-    uint8_t len = strlen(text);
-
-    if(len > 4) {
-        return;
+    fill = layout.len - len;
+    known = value_data == data && value_size == S;
+    for (uint8_t i = 0; i < layout.len; ++i) {
+        // Fillers are spaces
+        ch = i < fill ? ' ' : text[i - fill];
+        if(known && value_cells[i] == ch) {
+            continue;
+        }
+        set_cursor(VALUE_START_ROW, layout.col + i * font_cols(S));
+        put_char<S>(data, ch);
+        value_cells[i] = ch;
     }
+    value_cells[layout.len] = '\0';
+    value_data = data;
+    value_size = S;
+}
 
-    set_cursor(VALUE_START_ROW, 14);
-
-    // Put fillers
-    for (int i = 0; i < 4-len; ++i) {
-        put_font2028(data, s2028[1]);
+/* Print value in the given size */
+void print_value(uint8_t *data, const char *text, FontSize size) {
+    switch(size) {
+        case FontSize::Single:
+            print_value_as<FontSize::Single>(data, text);
+            break;
+        case FontSize::Double:
+            print_value_as<FontSize::Double>(data, text);
+            break;
+        case FontSize::Triple:
+            print_value_as<FontSize::Triple>(data, text);
+            break;
+        case FontSize::Quadro:
+            print_value_as<FontSize::Quadro>(data, text);
+            break;
     }
+}
 
-    print_font2028(data, text);
-#endif
+/* Forget the drawn value, the next print_value draws every cell */
+void forget_value(void) {
+    value_data = nullptr;
 }
 
-/* Print unit */
-void print_unit(uint32_t *data, enum UNITS unit) {
+/* Print unit on the last page of a value in the given size */
+void print_unit(uint8_t *data, enum UNITS unit, FontSize size) {
     struct unit_struct *unit_list = get_units();
 
-#ifdef SINGLE
-    set_cursor(0 + VALUE_START_ROW, UNIT_POSITION);
-#endif
-#ifdef DOUBLE
-    set_cursor(1 + VALUE_START_ROW, UNIT_POSITION);
-#endif
-#ifdef TRIPLE
-    set_cursor(2 + VALUE_START_ROW, UNIT_POSITION);
-#endif
-#ifdef QUADRO
-    set_cursor(3 + VALUE_START_ROW, UNIT_POSITION);
-#endif
+    set_cursor(font_pages(size) - 1 + VALUE_START_ROW, UNIT_POSITION);
 
     if(unit < LAST_UNIT) {
         print_font0507(data, unit_list[unit].unit_txt);
-        // cprintf("Unit: %s\n", unit_list[unit].unit_txt);
     } else {
         print_font0507(data, unit_list[LAST_UNIT].unit_txt);
     }
 }
 
-void debug_data(uint32_t *data) {
-    uint32_t b, w, mask;
+/* Fixed point value to text, str needs 8 bytes, returns 0 for unsupported decimals */
+int format_value(char *str, int32_t value, uint8_t decimals) {
+    // %ld takes a long, int32_t is long on the SAMD21 but int on the host
+    long number = value;
+    uint8_t negative = 0;
+
+    if(number < 0) {
+        negative = 1;
+        number = -number;
+    }
+
+    switch(decimals) {
+        case 0:
+            number = number%1000000;
+            if(negative) {
+                sprintf(str, "-%0ld", number);
+            } else {
+                sprintf(str, "%0ld", number);
+            }
+            break;
+        case 1:
+            number = number%100000;
+            if(negative) {
+                sprintf(str, "-%0ld.%01ld", number/10, number%10);
+            } else {
+                sprintf(str, "%0ld.%01ld", number/10, number%10);
+            }
+            break;
+        case 2:
+            number = number%100000;
+            if(negative) {
+                sprintf(str, "-%0ld.%02ld", number/100, number%100);
+            } else {
+                sprintf(str, "%0ld.%02ld", number/100, number%100);
+            }
+            break;
+        case 3:
+            number = number%100000;
+            if(negative) {
+                sprintf(str, "-%0ld.%03ld", number/1000, number%1000);
+            } else {
+                sprintf(str, "%0ld.%03ld", number/1000, number%1000);
+            }
+            break;
+        default:
+            return 0;
+    }
+
+    return 1;
+}
+
+void debug_data(uint8_t *data) {
     for (int y = 0; y < num_rows; ++y) {
         for (int i = 0; i < 8; ++i) {
             for (int x = 0; x < num_cols; ++x) {
-                b = x%4;
-                w = x/4;
-                mask = ((0x01 << i%8) << 8*b);
- 
-                Serial.print((data[y * (num_cols/4) + w] & mask)?"x":" ");
+                Serial.print((data[y*num_cols + x] & (0x01 << i))?"x":" ");
             }
             Serial.println();
         }
     }
+}
+
+/* Print flash use of the font tables, none of them take RAM */
+void font_memory_report(void) {
+#define FONT_TABLE_REPORT(table) \
+    Serial.print(#table); \
+    Serial.print(": "); \
+    Serial.print(sizeof(table)); \
+    Serial.println(" B flash");
+    FONT_TABLES(FONT_TABLE_REPORT)
+#undef FONT_TABLE_REPORT
+    Serial.print("Fonts total: ");
+    Serial.print(font_flash_bytes);
+    Serial.print(" of ");
+    Serial.print(FONT_FLASH_BUDGET);
+    Serial.println(" B flash, 0 B RAM");
 }
\ No newline at end of file
@@ -3,14 +3,19 @@
 
 #pragma once
 
-#define TRIPLE
+#include <stddef.h>
+#include <stdint.h>
+#include "indexList.h"
+
 #define HEADER_START_ROW    0
 #define VALUE_START_ROW     1
 #define UNIT_POSITION       110
+#define MAX_ROWS            8
+#define VALUE_MAX_CELLS     18
 
 #define c0507_MAXLEN        21
 
-#define C0507(ch) ((ch) >= 'A' && (ch) <= 'Z')?cs0507_up[(ch)-'A']:((ch) >= 'a' && (ch) <= 'z')?cs0507_low[(ch)-'a']:s0507[0]
+#define C0507(ch) (((ch) >= 'A' && (ch) <= 'Z')?&cs0507_up[(ch)-'A']:((ch) >= 'a' && (ch) <= 'z')?&cs0507_low[(ch)-'a']:&s0507[0])
 #define N0507(num) (num < 10)?nums0507[num]:s0507[0]
 #define N1014(num) (num < 10)?nums1014[num]:s1014[0]
 #define N1521(num) (num < 10)?nums1521[num]:s1521[0]
@@ -32,6 +37,33 @@ struct font2028 {
     const uint32_t col[20];
 };
 
+/* Glyph split into display pages, page-major, one byte per column */
+template <uint8_t W, uint8_t H>
+struct glyph {
+    uint8_t col[W * H];
+};
+
+typedef glyph<5, 1> glyph0507;
+typedef glyph<10, 2> glyph1014;
+typedef glyph<15, 3> glyph1521;
+typedef glyph<20, 4> glyph2028;
+
+template <uint8_t W, uint8_t H, typename F, size_t... I>
+constexpr glyph<W, H> split_glyph(const F &font, index_list<I...>) {
+    return glyph<W, H>{{static_cast<uint8_t>(font.col[I % W] >> (8 * (I / W)))...}};
+}
+
+/* Split a column-major font character into page rows at compile time */
+template <uint8_t W, uint8_t H, typename F>
+constexpr glyph<W, H> split_glyph(const F &font) {
+    return split_glyph<W, H>(font, typename make_index_list<W * H>::type());
+}
+
+#define G0507(ch) split_glyph<5, 1>(font0507 ch)
+#define G1014(ch) split_glyph<10, 2>(font1014 ch)
+#define G1521(ch) split_glyph<15, 3>(font1521 ch)
+#define G2028(ch) split_glyph<20, 4>(font2028 ch)
+
 #define c0507_UNKN {{0x7F, 0x41, 0x41, 0x41, 0x7F}}
 
 // Numbers
@@ -195,6 +227,22 @@ enum class Alignment {
     Right
 };
 
+/* Glyph scale, a character is 6 * size columns with its spacer and size pages */
+enum class FontSize : uint8_t {
+    Single = 1,
+    Double = 2,
+    Triple = 3,
+    Quadro = 4
+};
+
+constexpr uint8_t font_cols(FontSize size) {
+    return 6 * static_cast<uint8_t>(size);
+}
+
+constexpr uint8_t font_pages(FontSize size) {
+    return static_cast<uint8_t>(size);
+}
+
 enum UNITS {
     UNIT_P,     // bar
     UNIT_P2,    // kPa
@@ -229,16 +277,26 @@ struct unit_struct *get_units(void);
 int set_cursor(uint8_t row, uint8_t col);
 int set_row(uint8_t row);
 int set_col(uint8_t col);
-int put_font0507(uint32_t *data, struct font0507 ch);
-int put_font1014(uint32_t *data, struct font1014 ch);
-int put_font1521(uint32_t *data, struct font1521 ch);
-int put_font2028(uint32_t *data, struct font2028 ch);
-void print_font0507(uint32_t *data, const char *text);
-void print_font1014(uint32_t *data, const char *text);
-void print_font1521(uint32_t *data, const char *text);
-void print_font2028(uint32_t *data, const char *text);
-void print_header(uint32_t *data, const char *text, Alignment alignment = Alignment::Left);
-void print_value(uint32_t *data, const char *text);
-void print_unit(uint32_t *data, enum UNITS unit);
-void debug_data(uint32_t *data);
+void put_column(uint8_t *data, uint8_t row, uint8_t col, uint8_t bits);
+int put_font0507(uint8_t *data, const glyph0507 *ch);
+int put_font1014(uint8_t *data, const glyph1014 *ch);
+int put_font1521(uint8_t *data, const glyph1521 *ch);
+int put_font2028(uint8_t *data, const glyph2028 *ch);
+void print_font0507(uint8_t *data, const char *text);
+void print_font1014(uint8_t *data, const char *text);
+void print_font1521(uint8_t *data, const char *text);
+void print_font2028(uint8_t *data, const char *text);
+void print_font(uint8_t *data, FontSize size, const char *text);
+void print_header(uint8_t *data, const char *text, Alignment alignment = Alignment::Left);
+void print_value(uint8_t *data, const char *text, FontSize size);
+void print_unit(uint8_t *data, enum UNITS unit, FontSize size);
+void forget_value(void);
+int format_value(char *str, int32_t value, uint8_t decimals);
+void debug_data(uint8_t *data);
+void font_memory_report(void);
 void init_display(uint8_t cols, uint8_t rows);
+void mark_dirty(uint8_t row, uint8_t first_col, uint8_t last_col);
+void mark_all_dirty(void);
+int get_dirty(uint8_t row, uint8_t *first_col, uint8_t *last_col);
+int is_dirty(void);
+void clear_dirty(void);
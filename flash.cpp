@@ -0,0 +1,124 @@
+#include <Arduino.h>
+#include <string.h>
+#include "flash.h"
+#if defined(__AVR__)
+#include <avr/eeprom.h>
+#endif
+
+#if defined(ARDUINO_ARCH_SAMD)
+// Rows in the program image, uploading a sketch erases them along with the rest
+__attribute__((aligned(FLASH_BLOCK_BYTES))) static const volatile uint8_t flash_area[FLASH_BYTES] = {};
+
+static void nvm_command(uint32_t cmd, const volatile void *addr) {
+    NVMCTRL->ADDR.reg = reinterpret_cast<uint32_t>(addr) / 2;
+    NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | cmd;
+    while (!NVMCTRL->INTFLAG.bit.READY) {
+    }
+}
+
+bool flash_available(void) {
+    return true;
+}
+
+/* Volatile so the compiler doesn't fold reads of the all zero initialiser */
+void flash_read(uint32_t offset, void *data, size_t len) {
+    uint8_t *dst = static_cast<uint8_t *>(data);
+    for (size_t i = 0; i < len; ++i) {
+        dst[i] = flash_area[offset + i];
+    }
+}
+
+/* The page buffer takes 32-bit writes only, the rest of the page stays erased */
+bool flash_write(uint32_t offset, const void *data, size_t len) {
+    uint32_t page[FLASH_WRITE_BYTES / 4];
+    volatile uint32_t *dst = reinterpret_cast<volatile uint32_t *>(const_cast<volatile uint8_t *>(&flash_area[offset]));
+
+    if (offset % FLASH_WRITE_BYTES != 0 || len > FLASH_WRITE_BYTES) {
+        return false;
+    }
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, data, len);
+    // Manual write, the page is committed by the WP command
+    NVMCTRL->CTRLB.bit.MANW = 1;
+    nvm_command(NVMCTRL_CTRLA_CMD_PBC, dst);
+    for (size_t i = 0; i < FLASH_WRITE_BYTES / 4; ++i) {
+        dst[i] = page[i];
+    }
+    nvm_command(NVMCTRL_CTRLA_CMD_WP, dst);
+    return true;
+}
+
+bool flash_erase(uint32_t offset) {
+    if (offset % FLASH_BLOCK_BYTES != 0) {
+        return false;
+    }
+    nvm_command(NVMCTRL_CTRLA_CMD_ER, &flash_area[offset]);
+    return true;
+}
+#elif defined(__AVR__)
+bool flash_available(void) {
+    return true;
+}
+
+void flash_read(uint32_t offset, void *data, size_t len) {
+    eeprom_read_block(data, reinterpret_cast<const void *>(offset), len);
+}
+
+bool flash_write(uint32_t offset, const void *data, size_t len) {
+    if (offset % FLASH_WRITE_BYTES != 0 || len > FLASH_WRITE_BYTES) {
+        return false;
+    }
+    // Only bytes that differ are written, which also spares the cells
+    eeprom_update_block(data, reinterpret_cast<void *>(offset), len);
+    return true;
+}
+
+/* EEPROM bytes are rewritten in place */
+bool flash_erase(uint32_t offset) {
+    return offset % FLASH_BLOCK_BYTES == 0;
+}
+#elif defined(HOST_SIM)
+bool flash_available(void) {
+    return true;
+}
+
+void flash_read(uint32_t offset, void *data, size_t len) {
+    sim_flash_read(offset, data, len);
+}
+
+bool flash_write(uint32_t offset, const void *data, size_t len) {
+    if (offset % FLASH_WRITE_BYTES != 0 || len > FLASH_WRITE_BYTES) {
+        return false;
+    }
+    return sim_flash_write(offset, data, len);
+}
+
+bool flash_erase(uint32_t offset) {
+    if (offset % FLASH_BLOCK_BYTES != 0) {
+        return false;
+    }
+    sim_flash_erase(offset, FLASH_BLOCK_BYTES);
+    return true;
+}
+#else
+bool flash_available(void) {
+    return false;
+}
+
+void flash_read(uint32_t offset, void *data, size_t len) {
+    (void)offset;
+    memset(data, 0xFF, len);
+}
+
+bool flash_write(uint32_t offset, const void *data, size_t len) {
+    (void)offset;
+    (void)data;
+    (void)len;
+    return false;
+}
+
+bool flash_erase(uint32_t offset) {
+    (void)offset;
+    return false;
+}
+#endif
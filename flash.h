@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include "stdint.h"
+
+/*
+ * Non-volatile area for the settings log followed by two profile tables,
+ * see settings.h and profiles.h. It is erased in blocks and
+ * programmed in write units, an erased byte reads 0xFF. On the SAMD21 the
+ * area is a flash array in the program image, a write unit is a 64 byte
+ * page and a block a 256 byte row. On AVR it is the EEPROM, which needs
+ * no erase. The host build simulates the SAMD21.
+ */
+#if defined(__AVR__)
+#define FLASH_WRITE_BYTES       16
+#define FLASH_BLOCK_BYTES       16
+#define FLASH_LOG_BYTES         256
+#define FLASH_PROFILE_BYTES     384
+#else
+#define FLASH_WRITE_BYTES       64
+#define FLASH_BLOCK_BYTES       256
+#define FLASH_LOG_BYTES         4096
+#define FLASH_PROFILE_BYTES     512
+#endif
+#define FLASH_BYTES             (FLASH_LOG_BYTES + 2 * FLASH_PROFILE_BYTES)
+
+/* False when the board has no backend, settings then live in RAM only */
+bool flash_available(void);
+void flash_read(uint32_t offset, void *data, size_t len);
+/* Program up to one write unit at an aligned offset, the unit must be erased */
+bool flash_write(uint32_t offset, const void *data, size_t len);
+/* Erase the block at an aligned offset */
+bool flash_erase(uint32_t offset);
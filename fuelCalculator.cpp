@@ -0,0 +1,186 @@
+#include <Arduino.h>
+#include "fuelCalculator.h"
+#include "indexList.h"
+
+/*
+ * Laps are built the way the float code did: quotient, warmup and *100
+ * each rounded to a 24 bit mantissa, nearest and ties to even. Written as
+ * C++11 constexpr so the lookup table is generated from the same code.
+ *
+ * This is for exact results, not speed. A plain fixed point formula shows
+ * 4.20 laps for 112 settings where the float code showed 4.19. On the host
+ * it is slower than float, 32 against 5 ns with an FPU. It has not been
+ * timed on the FPU-less SAMD21, where the table answers in the settings
+ * range anyway. fuelmeter_calc compares it with float on every input.
+ */
+
+/* A positive float held as mantissa * 2^-shift */
+struct soft_float {
+    uint64_t mantissa;
+    int8_t shift;
+};
+
+static constexpr uint8_t cFLOAT_BITS = 24U;
+static constexpr uint8_t cQUOTIENT_STEPS = 2U;
+static constexpr int8_t cQUOTIENT_SHIFT = 16 * cQUOTIENT_STEPS;
+static constexpr uint32_t cWARMUP_MANTISSA = static_cast<uint32_t>(cWarmUpLapMultiplier * (1UL << (cFLOAT_BITS - 1)));
+static_assert(cWarmUpLapMultiplier >= 1.0F && cWarmUpLapMultiplier < 2.0F, "warmup mantissa assumes 1 <= multiplier < 2");
+
+static constexpr uint8_t excess_bits(uint64_t mantissa) {
+    return mantissa >= (1ULL << cFLOAT_BITS) ? 1 + excess_bits(mantissa >> 1) : 0;
+}
+
+static constexpr soft_float carry(soft_float f) {
+    return f.mantissa == (1ULL << cFLOAT_BITS) ? soft_float{f.mantissa >> 1, static_cast<int8_t>(f.shift - 1)} : f;
+}
+
+static constexpr soft_float round_up_if(soft_float f, bool up) {
+    return up ? carry(soft_float{f.mantissa + 1, f.shift}) : f;
+}
+
+static constexpr soft_float round_extra(soft_float f, uint8_t extra) {
+    return extra == 0 ? f : round_up_if(soft_float{f.mantissa >> extra, static_cast<int8_t>(f.shift - extra)},
+        (f.mantissa & ((1ULL << extra) - 1)) > (1ULL << (extra - 1)) ||
+        ((f.mantissa & ((1ULL << extra) - 1)) == (1ULL << (extra - 1)) && ((f.mantissa >> extra) & 1)));
+}
+
+static constexpr soft_float round_float(soft_float f) {
+    return round_extra(f, excess_bits(f.mantissa));
+}
+
+/* Long division in 16 bit steps keeps to 32 bit divides, a remainder
+   sets the low bit so an inexact quotient never looks like a tie */
+static constexpr soft_float quotient(uint64_t q, uint32_t rest, uint8_t laptime, uint8_t steps) {
+    return steps == 0 ? round_float(soft_float{(q << 1) | (rest != 0), static_cast<int8_t>(cQUOTIENT_SHIFT + 1)}) :
+        quotient((q << 16) | ((rest << 16) / laptime), (rest << 16) % laptime, laptime, steps - 1);
+}
+
+static constexpr soft_float add_warmup(soft_float f) {
+    return round_float(f.shift < cFLOAT_BITS - 1 ?
+        soft_float{(f.mantissa << (cFLOAT_BITS - 1 - f.shift)) + cWARMUP_MANTISSA, cFLOAT_BITS - 1} :
+        soft_float{f.mantissa + (static_cast<uint64_t>(cWARMUP_MANTISSA) << (f.shift - (cFLOAT_BITS - 1))), f.shift});
+}
+
+/* race_length * 60 / laptime (+ warmup) */
+static constexpr soft_float race_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime) {
+    return warmup != 0U ? add_warmup(race_laps(0U, race_length, laptime)) :
+        quotient(race_length * 60U / laptime, race_length * 60U % laptime, laptime, cQUOTIENT_STEPS);
+}
+
+static constexpr uint32_t truncate(soft_float f) {
+    return static_cast<uint32_t>(f.mantissa >> f.shift);
+}
+
+/* Hundredths, truncated like the float to int conversion did */
+static constexpr uint32_t laps_centi(soft_float laps) {
+    return truncate(round_float(soft_float{laps.mantissa * 100U, laps.shift}));
+}
+
+static constexpr uint32_t laps_whole(soft_float laps) {
+    return truncate(soft_float{laps.mantissa + (1ULL << laps.shift) - 1, laps.shift});
+}
+
+/*
+ * Optional table over the whole settings range. An entry is the laps in
+ * hundredths, the top bit set when the started laps are one more than
+ * the whole hundredths.
+ */
+#ifndef CALC_TABLE_BUDGET
+#if defined(__AVR__)
+#define CALC_TABLE_BUDGET   0
+#else
+#define CALC_TABLE_BUDGET   40960
+#endif
+#endif
+
+static constexpr uint16_t cTABLE_ROUND_UP = 0x8000U;
+static constexpr size_t cTABLE_LAPTIMES = cMAX_LAPTIME - cMIN_LAPTIME + 1;
+static constexpr size_t cTABLE_RACE_LENGTHS = cMAX_RACE_REMAINING - cMIN_RACE_REMAINING + 1;
+static constexpr size_t cTABLE_ENTRIES = 2 * cTABLE_RACE_LENGTHS * cTABLE_LAPTIMES;
+static constexpr size_t cTABLE_BYTES = cTABLE_ENTRIES * sizeof(uint16_t);
+
+struct laps_table {
+    uint16_t entry[cTABLE_ENTRIES];
+};
+
+static constexpr uint16_t table_entry(soft_float laps) {
+    return static_cast<uint16_t>(laps_centi(laps) | (laps_whole(laps) > laps_centi(laps) / 100U ? cTABLE_ROUND_UP : 0U));
+}
+
+static constexpr uint16_t table_entry(size_t i) {
+    return table_entry(race_laps(i / (cTABLE_RACE_LENGTHS * cTABLE_LAPTIMES),
+                                 cMIN_RACE_REMAINING + i / cTABLE_LAPTIMES % cTABLE_RACE_LENGTHS,
+                                 cMIN_LAPTIME + i % cTABLE_LAPTIMES));
+}
+
+template <size_t... I>
+constexpr laps_table make_laps_table(index_list<I...>) {
+    return laps_table{{table_entry(I)...}};
+}
+
+/* Only instantiated, and only in flash, when the table is within budget */
+template <bool Table, int Unused = 0>
+struct laps_lookup {
+    static bool find(uint8_t, uint8_t, uint8_t, uint16_t &) {
+        return false;
+    }
+};
+
+template <int Unused>
+struct laps_lookup<true, Unused> {
+    static const laps_table table;
+
+    static bool find(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint16_t &entry) {
+        if (race_length < cMIN_RACE_REMAINING || race_length > cMAX_RACE_REMAINING ||
+            laptime < cMIN_LAPTIME || laptime > cMAX_LAPTIME) {
+            return false;
+        }
+        entry = pgm_read_word(&table.entry[((warmup != 0U) * cTABLE_RACE_LENGTHS + race_length - cMIN_RACE_REMAINING) * cTABLE_LAPTIMES +
+                                           laptime - cMIN_LAPTIME]);
+        return true;
+    }
+};
+
+template <int Unused>
+const laps_table laps_lookup<true, Unused>::table PROGMEM = make_laps_table(make_index_list<cTABLE_ENTRIES>::type());
+
+static constexpr bool cCALC_TABLE = cTABLE_BYTES <= CALC_TABLE_BUDGET;
+
+/* Laps in hundredths */
+int32_t calculate_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime) {
+    uint16_t entry;
+
+    if (laps_lookup<cCALC_TABLE>::find(warmup, race_length, laptime, entry)) {
+        return entry & ~cTABLE_ROUND_UP;
+    }
+    return laps_centi(race_laps(warmup, race_length, laptime));
+}
+
+/* Laps to the flag, a started lap counts */
+int32_t calculate_whole_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime) {
+    uint16_t entry;
+
+    if (laps_lookup<cCALC_TABLE>::find(warmup, race_length, laptime, entry)) {
+        return (entry & ~cTABLE_ROUND_UP) / 100U + ((entry & cTABLE_ROUND_UP) != 0);
+    }
+    return laps_whole(race_laps(warmup, race_length, laptime));
+}
+
+/* Fuel for the started laps in tenths of a liter */
+int32_t calculate_fuel_needed(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint8_t fuel_consumption) {
+    return calculate_whole_laps(warmup, race_length, laptime) * fuel_consumption;
+}
+
+size_t calc_table_bytes(void) {
+    return cCALC_TABLE ? cTABLE_BYTES : 0;
+}
+
+void calc_memory_report(void) {
+    Serial.print("Calculator table: ");
+    Serial.print(calc_table_bytes());
+    Serial.print(" of ");
+    Serial.print(CALC_TABLE_BUDGET);
+    Serial.print(" B flash budget, needs ");
+    Serial.print(cTABLE_BYTES);
+    Serial.println(cCALC_TABLE ? " B" : " B, computing instead");
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "stddef.h"
+#include "stdint.h"
+#include "fuelMeter.h"
+
+/*
+ * Race fuel calculator in integer arithmetic. Results match the original
+ * float code bit for bit, including where float rounded 4.20 laps to 4.19.
+ */
+int32_t calculate_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime);
+int32_t calculate_whole_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime);
+int32_t calculate_fuel_needed(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint8_t fuel_consumption);
+size_t calc_table_bytes(void);
+void calc_memory_report(void);
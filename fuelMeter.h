@@ -24,6 +24,7 @@ static constexpr uint8_t cMAX_FUEL_CUNSUMPTION = 45U;
 static constexpr float cWarmUpLapMultiplier = 1.2F;
 
 static constexpr uint8_t cSEC_IN_MIN = 60U;
+static constexpr uint32_t cOLED_FRAME_MS = 1000U / 30U;
 
 enum class displayMode {
   None                = 0,
@@ -37,12 +38,34 @@ enum class displayMode {
   CalcFuelConsumption = 8,
   CalcFuelNeeded      = 9,
   CalcLaps            = 10,
+  FuelStatus          = 11,
+  LiveFuelNeeded      = 12,
+  CalcTankCapacity    = 13,
+  CalcPitLoss         = 14,
+  CalcPitStops        = 15,
 
-  LastMode
+  LastMode,
+  // Opened by a long press, not part of the short press cycle
+  ProfileSelect
 };
 
 enum class buttonPressMode {
   Short,
   Long,
+  Double,
+  Repeat,
   None
 };
+
+enum class inputEvent {
+  Button,
+  Encoder
+};
+
+/* Queued by the interrupt handlers, handled in loop() */
+struct input_event {
+  inputEvent type;
+  // Button pin level after the edge
+  uint8_t level;
+  uint32_t time_us;
+};
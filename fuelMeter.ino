@@ -1,16 +1,27 @@
 #include <Wire.h>
 #include "oled.h"
 #include "display.h"
+#include "widgets.h"
 #include "rotaryEncoder.h"
-#include "FuelMeter.h"
+#include "telemetry.h"
+#include "fuelCalculator.h"
+#include "fuelStrategy.h"
+#include "pitOptimizer.h"
+#include "trace.h"
+#include "power.h"
+#include "settings.h"
+#include "profiles.h"
+#include "gesture.h"
+#include "ringBuffer.h"
+#include "fuelMeter.h"
+#if defined(BENCHMARK)
+#include "bench.h"
+#endif
 
-#define BUFLEN 128
-char buf[BUFLEN] = "";
-uint8_t bufpos = 0;
 volatile displayMode mode = displayMode::None;
-uint32_t timestamp;
-uint32_t button_time;
-bool long_press;
+GestureEngine gestures;
+/* Page a short press stepped away from, a double click goes back from there */
+displayMode click_from_mode = displayMode::None;
 
 /* Calculator */
 static constexpr uint8_t cNUM_OF_RACE_LENGTH_OPTIONS = 8;
@@ -21,27 +32,276 @@ uint8_t race_length_index;
 bool custom_race_length;
 uint8_t laptime;
 uint8_t fuel_consumption;
+uint8_t tank_capacity;
+uint8_t pit_loss;
+SettingsStore store;
 char display_str[6] = "";
+char header_str[c0507_MAXLEN + 1] = "";
 volatile bool oled_updated;
 volatile bool fuel_updated;
 
-OLED oled = OLED(OLED_ADDRESS, 5*60);
+OLED oled = OLED(OLED_ADDRESS, cOLED_FRAME_MS);
 RotaryEncoder encoder_a(ROT1_CLK, ROT1_DAT, RotaryMode::HALF_STEP);
+Telemetry telemetry;
+
+/* Profile menu, a long press opens it over the current page */
+ProfileTable profiles;
+uint8_t profile_index;
+displayMode menu_return_mode;
+static_assert(PROFILE_TEXT_LEN <= c0507_MAXLEN, "Profile names must fit the header");
+
+/* LiveFuelNeeded page, fuel to the end of the race from lap telemetry */
+FuelStrategy strategy;
+
+/* FuelStatus page, fuel and laps remaining from binary telemetry */
+Dashboard dashboard;
+int8_t dash_fuel;
+int8_t dash_laps;
+int8_t dash_level;
+bool dashboard_shown;
+int32_t fuel_max;
+
+/* Only the pin interrupts push, they don't nest so there is one producer */
+static constexpr uint8_t cINPUT_EVENTS = 16U;
+RingBuffer<input_event, cINPUT_EVENTS> events;
+volatile bool encoder_queued;
+uint16_t events_dropped;
+uint32_t input_us;
+bool input_pending;
+bool input_drawn;
+uint32_t awake_report_ms;
+uint32_t awake_report_sleep_us;
+
+void setup_dashboard(void) {
+  dashboard.set_text(dashboard.add_text(0, 0, 6, FontSize::Single), "FUEL l");
+  dashboard.set_text(dashboard.add_text(0, 104, 4, FontSize::Single, Alignment::Right), "LAPS");
+  dash_fuel = dashboard.add_number(1, 0, 5, FontSize::Double, 1);
+  dash_laps = dashboard.add_number(1, 68, 5, FontSize::Double, 2);
+  dash_level = dashboard.add_bar(3, 0, COLUMNS, 0);
+}
 
+/* Car and track in the header, the profile number as the value */
+void show_profile_menu(void) {
+  if (profiles.count() == 0U) {
+    oled.set_header("NO PROFILES", Alignment::Center);
+    oled.set_value(" ---- ");
+    return;
+  }
+  profiles.get_text(profile_index, header_str);
+  oled.set_header(header_str, Alignment::Center);
+  oled.set_value(profile_index + 1, 0);
+}
+
+/* Header and unit of the current mode */
+void show_mode(void) {
+  oled_updated = true;
+  // The dashboard and the single value layout don't share regions
+  if ((mode == displayMode::FuelStatus) != dashboard_shown) {
+    dashboard_shown = !dashboard_shown;
+    oled.clear();
+    dashboard.invalidate();
+  }
+  switch(mode) {
+    case displayMode::FuelTime:
+      oled.set_header("FUEL USED THIS LAP");
+      oled.set_unit(UNIT_none);
+      break;
+    case displayMode::FuelUsedLap:
+      oled.set_header("LITERS PER LAP");
+      oled.set_unit(UNIT_none);
+      break;
+    case displayMode::FuelConsumption:
+      oled.set_header("FUEL REMAINING LAPS");
+      oled.set_unit(UNIT_none);
+      break;
+    case displayMode::FuelLaps:
+      oled.set_header("FUEL REMAINING TIME");
+      oled.set_unit(UNIT_none);
+      break;
+    case displayMode::CalcWarmup:
+      oled.set_header("FORMATION LAP?");
+      oled.set_unit(UNIT_none);
+      break;
+    case displayMode::CalcRaceLength:
+      if (custom_race_length) {
+        oled.set_header("RACE REMAINING?");
+      } else {
+        oled.set_header("RACE LENGTH?");
+      }
+      oled.set_unit(UNIT_min);
+      break;
+    case displayMode::CalcLaptime:
+      oled.set_header("LAPTIME?");
+      oled.set_unit(UNIT_none);
+      break;
+    case displayMode::CalcFuelConsumption:
+      oled.set_header("FUEL CONSUMPTION?");
+      oled.set_unit(UNIT_lL);
+      break;
+    case displayMode::CalcFuelNeeded:
+      oled.set_header("-> FUEL NEEDED", Alignment::Right);
+      oled.set_unit(UNIT_l);
+      fuel_updated = true;
+      break;
+    case displayMode::CalcLaps:
+      oled.set_header("-> LAPS", Alignment::Right);
+      oled.set_unit(UNIT_none);
+      fuel_updated = true;
+      break;
+    case displayMode::LiveFuelNeeded:
+      oled.set_header("LIVE FUEL NEEDED");
+      oled.set_unit(UNIT_l);
+      fuel_updated = true;
+      break;
+    case displayMode::CalcTankCapacity:
+      oled.set_header("TANK CAPACITY?");
+      oled.set_unit(UNIT_l);
+      break;
+    case displayMode::CalcPitLoss:
+      oled.set_header("PIT LANE LOSS?");
+      oled.set_unit(UNIT_s);
+      break;
+    case displayMode::CalcPitStops:
+      // The header comes with the plan
+      oled.set_unit(UNIT_l);
+      fuel_updated = true;
+      break;
+    case displayMode::ProfileSelect:
+      oled.set_unit(UNIT_none);
+      show_profile_menu();
+      break;
+    default:
+      break;
+  }
+}
+
+settings current_settings(void) {
+  return settings{warmup, race_length_index, race_length, static_cast<uint8_t>(custom_race_length),
+                  laptime, fuel_consumption, tank_capacity, pit_loss};
+}
+
+/* A record from another firmware could hold anything, the defaults stay then */
+bool valid_settings(const settings &values) {
+  return values.warmup <= 1U && values.custom_race_length <= 1U &&
+         values.race_length_index < cNUM_OF_RACE_LENGTH_OPTIONS &&
+         values.race_length >= cMIN_RACE_REMAINING && values.race_length <= cMAX_RACE_REMAINING &&
+         (values.custom_race_length != 0U || values.race_length == race_length_options[values.race_length_index]) &&
+         values.laptime >= cMIN_LAPTIME && values.laptime <= cMAX_LAPTIME &&
+         values.fuel_consumption >= cMIN_FUEL_CUNSUMPTION && values.fuel_consumption <= cMAX_FUEL_CUNSUMPTION &&
+         values.tank_capacity >= cMIN_TANK_CAPACITY && values.tank_capacity <= cMAX_TANK_CAPACITY &&
+         values.pit_loss >= cMIN_PIT_LOSS && values.pit_loss <= cMAX_PIT_LOSS;
+}
+
+/* Last calculator inputs from flash, one scan of the settings log */
+void restore_settings(void) {
+  settings values = current_settings();
+
+  if (!store.load(values) || !valid_settings(values)) {
+    return;
+  }
+  warmup = values.warmup;
+  race_length_index = values.race_length_index;
+  race_length = values.race_length;
+  custom_race_length = values.custom_race_length != 0U;
+  laptime = values.laptime;
+  fuel_consumption = values.fuel_consumption;
+  tank_capacity = values.tank_capacity;
+  pit_loss = values.pit_loss;
+}
+
+/* Flash is only written once the store has seen no change for a while */
+void save_settings(void) {
+  store.update(current_settings(), millis());
+}
+
+/* Every edge with its time, bounces included, loop() makes gestures of them */
 void button(void) {
-  buttonPressMode press_mode = buttonPressMode::None;
-  int modeint;
-  if (digitalRead(BUTTON) == 0) {
-    button_time = millis();
-  } else {
-    if (millis() - button_time > 1000) {
-      press_mode = buttonPressMode::Long;
+  events.push(input_event{inputEvent::Button, static_cast<uint8_t>(digitalRead(BUTTON)), micros()});
+}
+
+// abs(20-39) - abs(15-39)
+// 19-24
+// -5
+// abs(30-39) - abs(20-39)
+// 9-19
+// -10
+// abs(40-39) - abs(30-39)
+// 1-9
+// -8
+// abs(45-39) - abs(40-39)
+// 6-1
+// 5
+uint8_t find_race_length_index(uint8_t race_length) {
+  uint8_t closest_option = 0U;
+  int8_t diff;
+  for (int i = 1; i < cNUM_OF_RACE_LENGTH_OPTIONS; ++i) {
+    diff = abs(race_length_options[i] - race_length) - abs(race_length_options[closest_option] - race_length);
+    TRACE_D(RaceLengthDiff, diff);
+    if (diff > 0) {
+      return closest_option;
     } else {
-      press_mode = buttonPressMode::Short;
+      closest_option = i;
     }
   }
+  return closest_option;
+}
+
+void open_profile_menu(void) {
+  menu_return_mode = (mode == displayMode::None) ? displayMode::CalcWarmup : mode;
+  mode = displayMode::ProfileSelect;
+  show_mode();
+}
+
+/* All four inputs at once, the page behind the menu is then drawn once */
+void apply_profile(void) {
+  profile entry;
+
+  if (!profiles.get(profile_index, entry)) {
+    return;
+  }
+  warmup = entry.warmup;
+  laptime = entry.laptime;
+  fuel_consumption = entry.fuel_consumption;
+  race_length = entry.race_length;
+  race_length_index = find_race_length_index(race_length);
+  custom_race_length = race_length != race_length_options[race_length_index];
+  fuel_updated = true;
+}
+
+/* Short takes the profile, long leaves it, holding on scrolls */
+void handle_menu_button(buttonPressMode press_mode) {
+  switch (press_mode) {
+    case buttonPressMode::Repeat:
+      if (profiles.count() > 0U) {
+        profile_index = (profile_index + 1U) % profiles.count();
+        show_profile_menu();
+        oled_updated = true;
+      }
+      break;
+    case buttonPressMode::Short:
+      apply_profile();
+      mode = menu_return_mode;
+      show_mode();
+      break;
+    case buttonPressMode::Long:
+      mode = menu_return_mode;
+      show_mode();
+      break;
+    default:
+      break;
+  }
+}
 
+void handle_button(buttonPressMode press_mode) {
+  int modeint;
+  if (mode == displayMode::ProfileSelect) {
+    // The first click of a double click already left the menu
+    click_from_mode = displayMode::None;
+    handle_menu_button(press_mode);
+    return;
+  }
   if (press_mode == buttonPressMode::Short) {
+    click_from_mode = mode;
     if (mode == displayMode::None) {
       mode = displayMode::CalcWarmup;
     } else {
@@ -52,58 +312,9 @@ void button(void) {
         mode = static_cast<displayMode>(modeint);
       }
     }
-    oled_updated = true;
-    switch(mode) {
-      case displayMode::FuelTime:
-        oled.set_header("FUEL USED THIS LAP");
-        oled.set_unit(UNIT_none);
-        break;
-      case displayMode::FuelUsedLap:
-        oled.set_header("LITERS PER LAP");
-        oled.set_unit(UNIT_none);
-        break;
-      case displayMode::FuelConsumption:
-        oled.set_header("FUEL REMAINING LAPS");
-        oled.set_unit(UNIT_none);
-        break;
-      case displayMode::FuelLaps:
-        oled.set_header("FUEL REMAINING TIME");
-        oled.set_unit(UNIT_none);
-        break;
-      case displayMode::CalcWarmup:
-        oled.set_header("FORMATION LAP?");
-        oled.set_unit(UNIT_none);
-        break;
-      case displayMode::CalcRaceLength:
-        if (custom_race_length) {
-          oled.set_header("RACE REMAINING?");
-        } else {
-          oled.set_header("RACE LENGTH?");
-        }
-        oled.set_unit(UNIT_min);
-        break;
-      case displayMode::CalcLaptime:
-        oled.set_header("LAPTIME?");
-        oled.set_unit(UNIT_none);
-        break;
-      case displayMode::CalcFuelConsumption:
-        oled.set_header("FUEL CONSUMPTION?");
-        oled.set_unit(UNIT_lL);
-        break;
-      case displayMode::CalcFuelNeeded:
-        oled.set_header("-> FUEL NEEDED", Alignment::Right);
-        oled.set_unit(UNIT_l);
-        fuel_updated = true;
-        break;
-      case displayMode::CalcLaps:
-        oled.set_header("-> LAPS", Alignment::Right);
-        oled.set_unit(UNIT_none);
-        fuel_updated = true;
-        break;
-      default:
-        break;
-    }
+    show_mode();
   } else if (press_mode == buttonPressMode::Long) {
+    click_from_mode = displayMode::None;
     switch(mode) {
       case displayMode::CalcRaceLength:
         oled_updated = true;
@@ -115,13 +326,28 @@ void button(void) {
         }
         break;
       default:
+        open_profile_menu();
         break;
     }
+  } else if (press_mode == buttonPressMode::Double && click_from_mode != displayMode::None) {
+    // Undo the page step of the first click, then back one page
+    modeint = static_cast<int>(click_from_mode) - 1;
+    click_from_mode = displayMode::None;
+    if (modeint < static_cast<int>(displayMode::CalcWarmup)) {
+      mode = static_cast<displayMode>(static_cast<int>(displayMode::LastMode) - 1);
+    } else {
+      mode = static_cast<displayMode>(modeint);
+    }
+    show_mode();
   }
 }
 
+/* Steps are queued by the encoder, one event wakes the loop for all of them */
 void encoder(void) {
-  encoder_a.read();
+  encoder_a.isr();
+  if (!encoder_queued) {
+    encoder_queued = events.push(input_event{inputEvent::Encoder, 0U, micros()});
+  }
 }
 
 void setup() {
@@ -135,6 +361,10 @@ void setup() {
   race_length = race_length_options[race_length_index];
   laptime = 100U;
   fuel_consumption = 30U;
+  tank_capacity = 120U;
+  pit_loss = 30U;
+  restore_settings();
+  profiles.load();
   oled_updated = true;
   fuel_updated = true;
   Serial.begin(115200U);
@@ -142,10 +372,17 @@ void setup() {
   Wire.begin(I2C_SDA, I2C_SCL);
 #else
   Wire.begin();
+#endif
+#if defined(BENCHMARK)
+  // Before start(), the bench shares the display state and start() resets it
+  run_benchmarks(Serial);
 #endif
   oled.start();
+  setup_dashboard();
 
-  encoder_a.init();
+  encoder_a.init(true);
+  attachInterrupt(digitalPinToInterrupt(ROT1_CLK), encoder, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(ROT1_DAT), encoder, CHANGE);
 
   pinMode(BUTTON, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(BUTTON), button, CHANGE);
@@ -153,139 +390,237 @@ void setup() {
   oled.set_value("123456");
   oled.refresh();
 }
-// abs(20-39) - abs(15-39)
-// 19-24
-// -5
-// abs(30-39) - abs(20-39)
-// 9-19
-// -10
-// abs(40-39) - abs(30-39)
-// 1-9
-// -8
-// abs(45-39) - abs(40-39)
-// 6-1
-// 5
-uint8_t find_race_length_index(uint8_t race_length) {
-  uint8_t closest_option = 0U;
-  int8_t diff;
-  for (int i = 1; i < cNUM_OF_RACE_LENGTH_OPTIONS; ++i) {
-    diff = abs(race_length_options[i] - race_length) - abs(race_length_options[closest_option] - race_length);
-    Serial.println(diff);
-    if (diff > 0) {
-      return closest_option;
-    } else {
-      closest_option = i;
-    }
+
+/* Oldest input not on the display yet, for the latency trace */
+void note_input(uint32_t time_us) {
+  if (!input_pending) {
+    input_pending = true;
+    input_us = time_us;
   }
-  return closest_option;
 }
 
-float calculate_fuel_needed(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint8_t fuel_consumption) {
-  float fuel_needed = {};
-  int laps = 0;
-  laps = ceil(calculate_laps(warmup, race_length, laptime));
-  Serial.print("Laps ");
-  Serial.print(laps);
-  fuel_needed = laps * fuel_consumption;
-  Serial.print(", Fuel needed ");
-  Serial.println(fuel_needed / 10.0F);
-  return fuel_needed;
+/* Called once the display is idle, traces latency and awake time */
+void report_timing(void) {
+#if TRACE_LEVEL >= TRACE_INFO
+  uint32_t now_ms = millis();
+
+  // Inputs that changed nothing on screen are not counted
+  if (input_pending && input_drawn) {
+    TRACE_I(InputLatency, micros() - input_us);
+  }
+  if (now_ms - awake_report_ms >= 1000U) {
+    uint32_t slept_us = power_sleep_us() - awake_report_sleep_us;
+    TRACE_I(AwakePermille, 1000 - slept_us / (now_ms - awake_report_ms));
+    awake_report_ms = now_ms;
+    awake_report_sleep_us = power_sleep_us();
+  }
+#endif
+  input_pending = false;
+  input_drawn = false;
 }
 
-float calculate_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime) {
-  float laps = {};
-  laps = race_length * 60 / static_cast<float>(laptime);
-  Serial.print("Laps ");
-  Serial.print(laps);
-  if (warmup != 0U) {
-    laps += cWarmUpLapMultiplier;
-    Serial.print(" + 1");
+/* Sleep unless an interrupt queued work after the last look */
+void wait_for_event(void) {
+  noInterrupts();
+  if (events.empty() && Serial.available() == 0) {
+    power_idle();
+  } else {
+    interrupts();
   }
-  return laps;
 }
 
-void read_until() {
-  char tmp;
-  bufpos = 0;
-  tmp = Serial.read();
-  while (tmp != ';') {
-    Serial.print(tmp);
-    buf[bufpos++] = tmp;
-    tmp = Serial.read();
-    if (bufpos == BUFLEN) {
-      bufpos = BUFLEN-1;
-      break;
+bool is_telemetry_mode(void) {
+  return (mode >= displayMode::FuelTime && mode <= displayMode::FuelLaps) || mode == displayMode::FuelStatus ||
+         mode == displayMode::LiveFuelNeeded;
+}
+
+/* Fuel level bar is relative to the most fuel seen, a full tank */
+void update_dashboard(const fuel_packet &fuel) {
+  if (fuel.fuel_remaining > fuel_max) {
+    fuel_max = fuel.fuel_remaining;
+  }
+  dashboard.set_number(dash_fuel, fuel.fuel_remaining / 10);
+  dashboard.set_number(dash_laps, fuel.laps_remaining);
+  dashboard.set_bar(dash_level, fuel.fuel_remaining, fuel_max);
+}
+
+/* Start fuel in the value, stops and the first refuel in the header */
+void show_pit_plan(void) {
+  pit_plan plan;
+
+  if (!plan_pit_stops(warmup, race_length, laptime, fuel_consumption, tank_capacity, pit_loss, plan)) {
+    // Any tank covers the race with enough stops, the planner only tries a few
+    sprintf(header_str, "-> OVER %u STOPS", PIT_MAX_STOPS);
+    oled.set_header(header_str, Alignment::Right);
+    oled.set_value(" ---- ");
+    return;
+  }
+  if (plan.stops == 0U) {
+    sprintf(header_str, "-> NO STOP");
+  } else {
+    sprintf(header_str, "-> %u STOP%s +%u l", plan.stops, plan.stops > 1U ? "S" : "", (plan.fuel[1] + 9U) / 10U);
+  }
+  oled.set_header(header_str, Alignment::Right);
+  oled.set_value(plan.fuel[0], 1);
+}
+
+/* Feed queued laps to the strategy, true if any of them was new */
+bool add_laps(void) {
+  lap_packet lap;
+  bool added = false;
+
+  while (telemetry.next_lap(lap)) {
+    added |= strategy.add_lap(lap);
+  }
+  if (added) {
+    TRACE_I(LiveFuelNeeded, strategy.fuel_needed(race_length));
+  }
+  return added;
+}
+
+displayMode telemetry_mode_for(char tag) {
+  switch (tag) {
+    case 'T':
+      return displayMode::FuelTime;
+    case 'U':
+      return displayMode::FuelUsedLap;
+    case 'C':
+      return displayMode::FuelConsumption;
+    case 'L':
+      return displayMode::FuelLaps;
+    default:
+      return displayMode::None;
+  }
+}
+
+/* Profile table uploads, the menu follows a new table right away */
+void receive_profiles(void) {
+  blob_chunk chunk;
+  ProfileUpload result;
+
+  while (telemetry.next_chunk(chunk)) {
+    result = profiles.receive(chunk);
+    if (result == ProfileUpload::Receiving) {
+      continue;
+    }
+    TRACE_I(Profiles, result == ProfileUpload::Done ? profiles.count() : -1);
+    if (result == ProfileUpload::Done) {
+      profile_index = 0U;
+      if (mode == displayMode::ProfileSelect) {
+        show_profile_menu();
+        oled_updated = true;
+      }
     }
   }
-  buf[bufpos] = '\0';
 }
 
-void adjust_parameter(uint8_t dir, uint8_t *param, uint8_t min, uint8_t max) {
-  if (dir == DIR_CCW) {
-    if (*param > min) {
-      (*param)--;
+/* Show SimHub values as they arrive, never waits for the UART */
+void handle_telemetry(void) {
+  telemetry_frame *frame;
+
+  telemetry.poll();
+  receive_profiles();
+  while ((frame = telemetry.front()) != nullptr) {
+    // Completed laps, the strategy page follows them on the next loop
+    if (frame->tag == 'P') {
+      if (add_laps() && mode == displayMode::LiveFuelNeeded) {
+        note_input(frame->received_us);
+        fuel_updated = true;
+      }
+    // A binary packet ends with its laps frame
+    } else if (mode == displayMode::FuelStatus && frame->tag == 'L' && frame->numeric) {
+      note_input(frame->received_us);
+      update_dashboard(telemetry.fuel());
+      oled_updated = true;
+    } else if (telemetry_mode_for(frame->tag) == mode) {
+      note_input(frame->received_us);
+      if (frame->numeric) {
+        oled.set_value(frame->value, frame->decimals);
+      } else {
+        oled.set_value(frame->payload);
+      }
+      oled_updated = true;
     }
-  } else if (dir == DIR_CW) {
-    if (*param < max) {
-      (*param)++;
+    telemetry.release();
+  }
+
+  if (telemetry.check_link(millis()) && is_telemetry_mode()) {
+    if (telemetry.link() == TelemetryLink::Offline) {
+      oled.set_header("SIMHUB OFFLINE", Alignment::Center);
+      if (!dashboard_shown) {
+        oled.set_value(" ---- ");
+      }
+    } else {
+      dashboard.invalidate();
+      show_mode();
     }
+    oled_updated = true;
+  }
+}
+
+void adjust_parameter(int8_t delta, uint8_t *param, uint8_t min, uint8_t max) {
+  int16_t value = *param + delta;
+  if (value < min) {
+    value = min;
+  } else if (value > max) {
+    value = max;
   }
+  *param = static_cast<uint8_t>(value);
 }
 
 void loop() {
-  // char tmp;
-  // if (Serial.available() > 0) {
-  //   timestamp = millis();
-  //   tmp = Serial.read();
-  //   read_until();
-  //   switch (tmp) {
-  //     case 'T':
-  //       if (mode == displayMode::FuelTime) {
-  //         // oled.set_header("FUEL REMAINING TIME");
-  //         oled.set_value(buf);
-  //       }
-  //       break;
-  //     case 'U':
-  //       if (mode == displayMode::FuelUsedLap) {
-  //         // oled.set_header("FUEL USED THIS LAP");
-  //         oled.set_value(buf);
-  //       }
-  //       break;
-  //     case 'C':
-  //       if (mode == displayMode::FuelConsumption) {
-  //         // oled.set_header("LITERS PER LAP");
-  //         oled.set_value(buf);
-  //       }
-  //       break;
-  //     case 'L':
-  //       if (mode == displayMode::FuelLaps) {
-  //         // oled.set_header("FUEL REMAINING LAPS");
-  //         oled.set_value(buf);
-  //       }
-  //       break;
-  //     default:
-  //       break;
-  //   }
-  // }
-
-  // if (millis() - timestamp > 5000) {
-  //   oled.set_header("SIMHUB OFFLINE", Alignment::Center);
-  //   oled.set_value(" ---- ");
-  // }
-
-  uint8_t dir = encoder_a.read();
+  input_event event;
+  buttonPressMode gesture;
+
+  // Everything that arrived since the last pass costs one redraw
+  while (events.pop(event)) {
+    if (event.type == inputEvent::Button) {
+      gestures.edge(event.level, event.time_us);
+    } else {
+      encoder_queued = false;
+    }
+    note_input(event.time_us);
+  }
+  // A lost edge could leave the button stuck down, the pin has the truth
+  if (events.dropped() != events_dropped) {
+    events_dropped = events.dropped();
+    gestures.edge(static_cast<uint8_t>(digitalRead(BUTTON)), micros());
+  }
+  gestures.update(micros());
+  while (gestures.next(gesture)) {
+    handle_button(gesture);
+  }
+  handle_telemetry();
+
+  // All queued steps at once so a fast spin costs one redraw
+  int8_t delta = encoder_a.read_delta();
 
   if (mode == displayMode::CalcFuelNeeded && fuel_updated) {
-    int fuel_needed = static_cast<int>(calculate_fuel_needed(warmup, race_length, laptime, fuel_consumption));
+    int32_t fuel_needed = calculate_fuel_needed(warmup, race_length, laptime, fuel_consumption);
+    TRACE_I(FuelNeeded, fuel_needed);
     oled.set_value(fuel_needed, 1);
     oled_updated = true;
     fuel_updated = false;
   } else if (mode == displayMode::CalcLaps && fuel_updated) {
-    float laps = calculate_laps(warmup, race_length, laptime)*100;
+    int32_t laps = calculate_laps(warmup, race_length, laptime);
+    TRACE_I(Laps, laps);
     oled.set_value(laps, 2);
     oled_updated = true;
     fuel_updated = false;
-  } else if (dir != DIR_NONE) {
+  } else if (mode == displayMode::CalcPitStops && fuel_updated) {
+    show_pit_plan();
+    oled_updated = true;
+    fuel_updated = false;
+  } else if (mode == displayMode::LiveFuelNeeded && fuel_updated) {
+    int32_t fuel_needed = strategy.fuel_needed(race_length);
+    if (fuel_needed < 0) {
+      oled.set_value(" ---- ");
+    } else {
+      oled.set_value(fuel_needed, 1);
+    }
+    oled_updated = true;
+    fuel_updated = false;
+  } else if (delta != 0) {
     oled_updated = true;
     fuel_updated = true;
   }
@@ -294,35 +629,63 @@ void loop() {
     oled_updated = false;
     switch (mode) {
       case displayMode::CalcWarmup:
-        adjust_parameter(dir, &warmup, false, true);
+        adjust_parameter(delta, &warmup, false, true);
         sprintf(display_str, "%s", warmup!=0U?"YES":"NO");
         oled.set_value(display_str);
         break;
       case displayMode::CalcLaptime:
-        adjust_parameter(dir, &laptime, cMIN_LAPTIME, cMAX_LAPTIME);
+        adjust_parameter(delta, &laptime, cMIN_LAPTIME, cMAX_LAPTIME);
         sprintf(display_str, "%d:%02d", laptime / cSEC_IN_MIN, laptime % cSEC_IN_MIN);
         oled.set_value(display_str);
         break;
       case displayMode::CalcRaceLength:
         if (custom_race_length) {
-          adjust_parameter(dir, &race_length, cMIN_RACE_REMAINING, cMAX_RACE_REMAINING);
+          adjust_parameter(delta, &race_length, cMIN_RACE_REMAINING, cMAX_RACE_REMAINING);
           race_length_index = find_race_length_index(race_length);
+          TRACE_D(RaceLengthIndex, race_length_index);
         } else {
-          adjust_parameter(dir, &race_length_index, 0, cNUM_OF_RACE_LENGTH_OPTIONS - 1);
+          adjust_parameter((delta > 0) - (delta < 0), &race_length_index, 0, cNUM_OF_RACE_LENGTH_OPTIONS - 1);
           race_length = race_length_options[race_length_index];
         }
         oled.set_value(race_length, 0);
         break;
       case displayMode::CalcFuelConsumption:
-        adjust_parameter(dir, &fuel_consumption, cMIN_FUEL_CUNSUMPTION, cMAX_FUEL_CUNSUMPTION);
+        adjust_parameter(delta, &fuel_consumption, cMIN_FUEL_CUNSUMPTION, cMAX_FUEL_CUNSUMPTION);
         oled.set_value(fuel_consumption, 1);
         break;
+      case displayMode::CalcTankCapacity:
+        adjust_parameter(delta, &tank_capacity, cMIN_TANK_CAPACITY, cMAX_TANK_CAPACITY);
+        oled.set_value(tank_capacity, 0);
+        break;
+      case displayMode::CalcPitLoss:
+        adjust_parameter(delta, &pit_loss, cMIN_PIT_LOSS, cMAX_PIT_LOSS);
+        oled.set_value(pit_loss, 0);
+        break;
+      case displayMode::FuelStatus:
+        oled.draw(dashboard);
+        break;
+      case displayMode::ProfileSelect:
+        if (delta != 0 && profiles.count() > 0U) {
+          adjust_parameter(delta, &profile_index, 0U, profiles.count() - 1U);
+          show_profile_menu();
+        }
+        break;
       default:
         break;
     }
 
+    input_drawn = input_pending;
     oled.refresh();
-  } else {
-    delay(5);
+    save_settings();
+  } else if (!oled.service()) {
+    // A frame held back by the rate cap hasn't reached the panel yet
+    if (!oled.busy()) {
+      report_timing();
+      trace_drain();
+      if (store.service(millis())) {
+        TRACE_D(SettingsWrites, store.get_stats().writes);
+      }
+    }
+    wait_for_event();
   }
 }
@@ -0,0 +1,80 @@
+#include "fuelStrategy.h"
+#include "fuelCalculator.h"
+
+/* Returns false for a lap that was already counted */
+bool FuelStrategy::add_lap(const lap_packet &lap) {
+    if (lap.lap == m_lap) {
+        return false;
+    }
+    // Lap counter going back means a new session
+    if (lap.lap < m_lap) {
+        reset();
+    }
+    m_lap = lap.lap;
+    m_fuel.add(lap.fuel_used);
+    m_laptime.add(lap.laptime);
+    m_elapsed += lap.laptime;
+    return true;
+}
+
+void FuelStrategy::reset(void) {
+    m_fuel.reset();
+    m_laptime.reset();
+    m_lap = 0;
+    m_elapsed = 0;
+}
+
+uint8_t FuelStrategy::laps(void) const {
+    return m_fuel.count();
+}
+
+/* Tenths of a liter per lap with the margin, rounded up */
+uint16_t FuelStrategy::consumption(void) const {
+    uint32_t centi = m_fuel.mean() + static_cast<uint32_t>(cFUEL_MARGIN_SIGMA) * m_fuel.stddev();
+
+    return static_cast<uint16_t>((centi + 9U) / 10U);
+}
+
+/* Whole seconds rounded down, a shorter lap fits more laps in the race */
+uint8_t FuelStrategy::laptime(void) const {
+    uint16_t seconds = m_laptime.mean() / 100U;
+
+    if (seconds == 0U) {
+        return 1U;
+    }
+    return seconds > UINT8_MAX ? UINT8_MAX : static_cast<uint8_t>(seconds);
+}
+
+/* Minutes left of a race_length minute race, a started minute counts */
+uint8_t FuelStrategy::race_remaining(uint8_t race_length) const {
+    uint32_t total = static_cast<uint32_t>(race_length) * 60U * 100U;
+
+    if (m_elapsed >= total) {
+        return 0U;
+    }
+    return static_cast<uint8_t>((total - m_elapsed + 60U * 100U - 1U) / (60U * 100U));
+}
+
+/*
+ * Tenths of a liter to the end of the race, -1 until the first lap. The
+ * formation lap is behind us once laps are coming in, so no warmup.
+ */
+int32_t FuelStrategy::fuel_needed(uint8_t race_length) const {
+    uint16_t per_lap = consumption();
+
+    if (laps() == 0U) {
+        return -1;
+    }
+    if (per_lap > UINT8_MAX) {
+        per_lap = UINT8_MAX;
+    }
+    return calculate_fuel_needed(0U, race_remaining(race_length), laptime(), static_cast<uint8_t>(per_lap));
+}
+
+const RollingStats<STRATEGY_LAPS> &FuelStrategy::fuel_stats(void) const {
+    return m_fuel;
+}
+
+const RollingStats<STRATEGY_LAPS> &FuelStrategy::laptime_stats(void) const {
+    return m_laptime;
+}
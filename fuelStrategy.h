@@ -0,0 +1,36 @@
+#pragma once
+
+#include "stdint.h"
+#include "rollingStats.h"
+#include "telemetryProtocol.h"
+
+/* Laps the statistics look back over */
+#define STRATEGY_LAPS           8
+
+/* Consumption margin in standard deviations of fuel per lap */
+static constexpr uint8_t cFUEL_MARGIN_SIGMA = 2U;
+
+/*
+ * Live fuel strategy from lap telemetry. Each completed lap updates the
+ * rolling statistics in O(1), fuel needed to the end of the race is then
+ * one calculate_fuel_needed() call on the rolling means.
+ */
+class FuelStrategy {
+public:
+    bool add_lap(const lap_packet &lap);
+    void reset(void);
+    uint8_t laps(void) const;
+    uint16_t consumption(void) const;
+    uint8_t laptime(void) const;
+    uint8_t race_remaining(uint8_t race_length) const;
+    int32_t fuel_needed(uint8_t race_length) const;
+    const RollingStats<STRATEGY_LAPS> &fuel_stats(void) const;
+    const RollingStats<STRATEGY_LAPS> &laptime_stats(void) const;
+
+private:
+    RollingStats<STRATEGY_LAPS> m_fuel;
+    RollingStats<STRATEGY_LAPS> m_laptime;
+    uint16_t m_lap {0};
+    // Race time driven so far, 0.01 s
+    uint32_t m_elapsed {0};
+};
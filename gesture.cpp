@@ -0,0 +1,57 @@
+#include "gesture.h"
+
+void GestureEngine::emit(buttonPressMode gesture) {
+    m_gestures.push(gesture);
+}
+
+/* Take the last edge once nothing followed it for the debounce time */
+void GestureEngine::settle(uint32_t now_us) {
+    if (m_raw == m_level || now_us - m_raw_us < cDEBOUNCE_US) {
+        return;
+    }
+    m_level = m_raw;
+    if (m_level == 0U) {
+        m_down_us = m_raw_us;
+        m_long = false;
+    } else if (!m_long) {
+        if (m_clicks == 1U && m_down_us - m_up_us < cDOUBLE_CLICK_US) {
+            m_clicks = 0;
+            emit(buttonPressMode::Double);
+        } else {
+            m_clicks = 1;
+            m_up_us = m_raw_us;
+            emit(buttonPressMode::Short);
+        }
+    }
+}
+
+/* Edges must come in the order they happened */
+void GestureEngine::edge(uint8_t level, uint32_t time_us) {
+    update(time_us);
+    if (level != m_raw) {
+        m_raw = level;
+        m_raw_us = time_us;
+    }
+}
+
+void GestureEngine::update(uint32_t now_us) {
+    settle(now_us);
+    if (m_level == 0U) {
+        if (!m_long && now_us - m_down_us >= cLONG_PRESS_US) {
+            m_clicks = 0;
+            m_long = true;
+            m_repeat_us = m_down_us + cLONG_PRESS_US + cREPEAT_DELAY_US;
+            emit(buttonPressMode::Long);
+        } else if (m_long && static_cast<int32_t>(now_us - m_repeat_us) >= 0) {
+            m_repeat_us += cREPEAT_US;
+            emit(buttonPressMode::Repeat);
+        }
+    } else if (m_clicks == 1U && now_us - m_up_us >= cDOUBLE_CLICK_US) {
+        // Too late for a second click, the next one starts afresh
+        m_clicks = 0;
+    }
+}
+
+bool GestureEngine::next(buttonPressMode &gesture) {
+    return m_gestures.pop(gesture);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "stdint.h"
+#include "ringBuffer.h"
+#include "fuelMeter.h"
+
+#define GESTURE_QUEUE           4
+
+/* A level has to hold this long to count, bounces in between are ignored */
+static constexpr uint32_t cDEBOUNCE_US = 5000U;
+static constexpr uint32_t cLONG_PRESS_US = 1000000U;
+/* A second press starting this soon after a click makes it a double click */
+static constexpr uint32_t cDOUBLE_CLICK_US = 250000U;
+static constexpr uint32_t cREPEAT_DELAY_US = 500000U;
+static constexpr uint32_t cREPEAT_US = 150000U;
+
+/*
+ * Button gestures from timestamped edges, all in loop() context. The
+ * interrupt only queues the pin level and the time, edge() takes them in
+ * order and update() runs the timers in between. A click is reported as
+ * Short on release, without waiting, and a second one within
+ * cDOUBLE_CLICK_US as Double instead. So a Double always follows the
+ * Short of its first click. A long press is reported while the button is
+ * still down, holding on repeats every cREPEAT_US after cREPEAT_DELAY_US.
+ * The button is low-active.
+ */
+class GestureEngine {
+public:
+    void edge(uint8_t level, uint32_t time_us);
+    void update(uint32_t now_us);
+    bool next(buttonPressMode &gesture);
+
+private:
+    void settle(uint32_t now_us);
+    void emit(buttonPressMode gesture);
+
+    // Last edge seen and the debounced level
+    uint8_t m_raw {1};
+    uint32_t m_raw_us {0};
+    uint8_t m_level {1};
+    uint32_t m_down_us {0};
+    uint32_t m_up_us {0};
+    uint32_t m_repeat_us {0};
+    uint8_t m_clicks {0};
+    bool m_long {false};
+    RingBuffer<buttonPressMode, GESTURE_QUEUE> m_gestures;
+};
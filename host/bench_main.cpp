@@ -0,0 +1,21 @@
+/*   bench_main.cpp - Host runner for the render and flush benchmarks   */
+
+#include <stdio.h>
+#include "hal.h"
+#include "bench.h"
+
+class StdoutPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        return fputc(c, stdout) == EOF ? 0 : 1;
+    }
+    using Print::write;
+};
+
+int main(void) {
+    StdoutPrint out;
+
+    sim_reset();
+    run_benchmarks(out);
+    return 0;
+}
@@ -0,0 +1,43 @@
+/*   calc_main.cpp - Integer calculator against the float code it replaced, every input   */
+
+#include <math.h>
+#include <stdio.h>
+#include "fuelCalculator.h"
+
+/* The sketch's calculate_laps() before it moved to integers */
+static float float_laps(uint8_t warmup, uint8_t race_length, uint8_t laptime) {
+    float laps = race_length * 60 / static_cast<float>(laptime);
+
+    if (warmup != 0U) {
+        laps += cWarmUpLapMultiplier;
+    }
+    return laps;
+}
+
+/* Every uint8_t input, not only the settings range, laptime 0 divides by zero */
+int main(void) {
+    unsigned long cases = 0;
+    unsigned long errors = 0;
+
+    for (int warmup = 0; warmup <= 1; ++warmup) {
+        for (int race_length = 0; race_length <= 255; ++race_length) {
+            for (int laptime = 1; laptime <= 255; ++laptime) {
+                float laps = float_laps(warmup, race_length, laptime);
+                // CalcLaps showed the float times 100 as an int32_t
+                int32_t centi = static_cast<int32_t>(laps * 100);
+                int32_t whole = static_cast<int32_t>(ceil(laps));
+
+                cases += 2;
+                errors += calculate_laps(warmup, race_length, laptime) != centi;
+                errors += calculate_whole_laps(warmup, race_length, laptime) != whole;
+                for (int consumption = 0; consumption <= 255; ++consumption) {
+                    cases++;
+                    errors += calculate_fuel_needed(warmup, race_length, laptime, consumption) != whole * consumption;
+                }
+            }
+        }
+    }
+    printf("calculator: %lu cases with a %lu B table, %lu differ from float\n", cases,
+           static_cast<unsigned long>(calc_table_bytes()), errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+/*   Arduino.h - Host stand-in for the Arduino core   */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define HIGH            1
+#define LOW             0
+
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+
+#define CHANGE          1
+#define FALLING         2
+#define RISING          3
+
+#define PROGMEM
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t *>(addr))
+#define memcpy_P        memcpy
+#define memcmp_P        memcmp
+
+#define digitalPinToInterrupt(pin)  (pin)
+/* All simulated pins share one 32-bit input port */
+#define digitalPinToPort(pin)       (0)
+#define digitalPinToBitMask(pin)    (1UL << (pin))
+#define portInputRegister(port)     (&sim_port_in)
+
+extern volatile uint32_t sim_port_in;
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts(void);
+void interrupts(void);
+
+/* WFI of the simulated core, wakes on a pin change or the 1 ms tick */
+#define HOST_SIM
+void sim_idle(void);
+
+/* NOR flash of the simulated board, programming only clears bits */
+void sim_flash_read(uint32_t offset, void *data, size_t len);
+bool sim_flash_write(uint32_t offset, const void *data, size_t len);
+void sim_flash_erase(uint32_t offset, size_t len);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t len);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(int value);
+    size_t print(unsigned int value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int digits = 2);
+    size_t println(void);
+    template <typename T>
+    size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+};
+
+/*
+ * Serial port, TX is captured and optionally echoed to stdout,
+ * RX is fed by sim_serial_inject()
+ */
+class HostSerial : public Print {
+public:
+    void begin(unsigned long baud);
+    int available(void);
+    int availableForWrite(void);
+    int read(void);
+    int peek(void);
+    size_t write(uint8_t c) override;
+    using Print::write;
+};
+
+extern HostSerial Serial;
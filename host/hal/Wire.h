@@ -0,0 +1,22 @@
+/*   Wire.h - Host stand-in for the Arduino I2C driver   */
+
+#pragma once
+
+#include "Arduino.h"
+
+/*
+ * Every transaction is recorded with its start time and the virtual
+ * clock advances by the time the bytes take on the bus
+ */
+class TwoWire {
+public:
+    void begin(void);
+    void begin(int sda, int scl);
+    void setClock(uint32_t hz);
+    void beginTransmission(uint8_t addr);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t len);
+    uint8_t endTransmission(bool stop = true);
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,474 @@
+/*   hal.cpp - Simulated board for host builds   */
+
+#include <algorithm>
+#include <chrono>
+#include "Arduino.h"
+#include "Wire.h"
+#include "hal.h"
+#include "flash.h"
+
+#define SIM_PINS        32
+#define SIM_I2C_HZ      100000UL
+/* SAMD21 datasheet typicals, the core stalls while the NVM is busy */
+#define SIM_FLASH_ERASE_US      6000U
+#define SIM_FLASH_WRITE_US      2500U
+
+struct sim_pin_event {
+    uint64_t time_us;
+    uint8_t pin;
+    uint8_t level;
+};
+
+volatile uint32_t sim_port_in;
+HostSerial Serial;
+TwoWire Wire;
+
+static uint64_t now_us;
+static uint8_t pin_mode[SIM_PINS];
+static void (*pin_isr[SIM_PINS])(void);
+static int pin_isr_mode[SIM_PINS];
+static bool irq_enabled = true;
+static uint32_t irq_pending;
+static std::vector<sim_pin_event> pin_events;
+static sim_isr_stats isr_stats[SIM_PINS];
+
+static uint32_t i2c_hz = SIM_I2C_HZ;
+static std::vector<sim_i2c_transaction> i2c_log;
+static sim_i2c_transaction i2c_current;
+static uint32_t i2c_bytes;
+
+static std::vector<uint8_t> serial_rx;
+static size_t serial_rx_pos;
+static std::vector<uint8_t> serial_tx;
+static bool serial_echo;
+
+static uint8_t flash_mem[FLASH_BYTES];
+static bool flash_ready;
+static size_t flash_tear = FLASH_WRITE_BYTES;
+// Power is gone after a torn write, nothing more is programmed until reset
+static bool flash_off;
+static sim_flash_stats flash_stats;
+static std::vector<uint32_t> flash_wear(FLASH_BYTES / FLASH_BLOCK_BYTES);
+
+/* Host time of the handler, the virtual clock stands still in it */
+static void run_isr(uint8_t pin) {
+    auto start = std::chrono::steady_clock::now();
+    pin_isr[pin]();
+    uint32_t ns = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    sim_isr_stats &stats = isr_stats[pin];
+    stats.calls++;
+    stats.total_ns += ns;
+    stats.max_ns = std::max(stats.max_ns, ns);
+}
+
+static void apply_pin(uint8_t pin, uint8_t level) {
+    uint32_t mask = 1UL << pin;
+    uint8_t old_level = (sim_port_in & mask) ? HIGH : LOW;
+
+    if (level) {
+        sim_port_in |= mask;
+    } else {
+        sim_port_in &= ~mask;
+    }
+    if (old_level == level || pin_isr[pin] == nullptr) {
+        return;
+    }
+    if (pin_isr_mode[pin] == CHANGE ||
+        (pin_isr_mode[pin] == RISING && level == HIGH) ||
+        (pin_isr_mode[pin] == FALLING && level == LOW)) {
+        // Masked interrupts stay pending like on the NVIC
+        if (irq_enabled) {
+            run_isr(pin);
+        } else {
+            irq_pending |= mask;
+        }
+    }
+}
+
+/* Virtual clock */
+void sim_reset(void) {
+    now_us = 0;
+    sim_port_in = 0xFFFFFFFFUL;
+    memset(pin_mode, 0, sizeof(pin_mode));
+    memset(pin_isr, 0, sizeof(pin_isr));
+    memset(pin_isr_mode, 0, sizeof(pin_isr_mode));
+    irq_enabled = true;
+    irq_pending = 0;
+    pin_events.clear();
+    i2c_log.clear();
+    i2c_bytes = 0;
+    serial_rx.clear();
+    serial_rx_pos = 0;
+    serial_tx.clear();
+    flash_off = false;
+}
+
+uint64_t sim_time_us(void) {
+    return now_us;
+}
+
+/* Move the clock forward, firing scheduled pin changes on the way */
+void sim_advance_us(uint64_t us) {
+    uint64_t end = now_us + us;
+
+    while (!pin_events.empty() && pin_events.front().time_us <= end) {
+        sim_pin_event event = pin_events.front();
+        pin_events.erase(pin_events.begin());
+        if (event.time_us > now_us) {
+            now_us = event.time_us;
+        }
+        apply_pin(event.pin, event.level);
+    }
+    now_us = end;
+}
+
+static void schedule_pin(uint64_t time_us, uint8_t pin, uint8_t level) {
+    sim_pin_event event = {time_us, pin, level};
+    auto pos = std::upper_bound(pin_events.begin(), pin_events.end(), event,
+        [](const sim_pin_event &a, const sim_pin_event &b) { return a.time_us < b.time_us; });
+    pin_events.insert(pos, event);
+}
+
+uint32_t millis(void) {
+    return static_cast<uint32_t>(now_us / 1000U);
+}
+
+uint32_t micros(void) {
+    return static_cast<uint32_t>(now_us);
+}
+
+void delay(uint32_t ms) {
+    sim_advance_us(static_cast<uint64_t>(ms) * 1000U);
+}
+
+void delayMicroseconds(uint32_t us) {
+    sim_advance_us(us);
+}
+
+/* GPIO */
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < SIM_PINS) {
+        pin_mode[pin] = mode;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return (pin < SIM_PINS && (sim_port_in & (1UL << pin))) ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < SIM_PINS && pin_mode[pin] == OUTPUT) {
+        apply_pin(pin, value ? HIGH : LOW);
+    }
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode) {
+    if (interrupt < SIM_PINS) {
+        pin_isr[interrupt] = isr;
+        pin_isr_mode[interrupt] = mode;
+    }
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < SIM_PINS) {
+        pin_isr[interrupt] = nullptr;
+    }
+}
+
+void noInterrupts(void) {
+    irq_enabled = false;
+}
+
+void interrupts(void) {
+    irq_enabled = true;
+    while (irq_pending != 0) {
+        uint8_t pin = 0;
+        while (!(irq_pending & (1UL << pin))) {
+            pin++;
+        }
+        irq_pending &= ~(1UL << pin);
+        if (pin_isr[pin] != nullptr) {
+            run_isr(pin);
+        }
+    }
+}
+
+void sim_idle(void) {
+    uint64_t wake_us = (now_us / 1000U + 1) * 1000U;
+
+    if (!pin_events.empty() && pin_events.front().time_us < wake_us) {
+        wake_us = std::max(pin_events.front().time_us, now_us);
+    }
+    sim_advance_us(wake_us - now_us);
+}
+
+void sim_set_pin(uint8_t pin, uint8_t level) {
+    schedule_pin(now_us, pin, level ? HIGH : LOW);
+    sim_advance_us(0);
+}
+
+void sim_rotate(uint8_t pin_a, uint8_t pin_b, int steps, uint32_t edge_interval_us) {
+    static const uint8_t gray[4] = {0x0, 0x1, 0x3, 0x2};
+    uint8_t state = ((sim_port_in >> pin_a) & 0x1) | (((sim_port_in >> pin_b) & 0x1) << 1);
+    uint8_t pos = 0;
+    uint64_t time_us = now_us;
+
+    while (gray[pos] != state) {
+        pos++;
+    }
+    for (int i = 0; i < abs(steps); ++i) {
+        pos = (steps > 0) ? (pos + 1) & 0x3 : (pos + 3) & 0x3;
+        time_us += edge_interval_us;
+        schedule_pin(time_us, pin_a, gray[pos] & 0x1);
+        schedule_pin(time_us, pin_b, (gray[pos] >> 1) & 0x1);
+    }
+}
+
+/* Contacts chatter for bounce_us after each change, four edges evenly spread */
+static void schedule_bounce(uint64_t time_us, uint8_t pin, uint8_t level, uint32_t bounce_us) {
+    for (uint32_t i = 0; i < 4U && bounce_us > 0U; ++i) {
+        schedule_pin(time_us + bounce_us * i / 4U, pin, (i & 1U) ? !level : level);
+    }
+    schedule_pin(time_us + bounce_us, pin, level);
+}
+
+void sim_press(uint8_t pin, uint32_t hold_ms, uint32_t bounce_us) {
+    schedule_bounce(now_us, pin, LOW, bounce_us);
+    schedule_bounce(now_us + static_cast<uint64_t>(hold_ms) * 1000U, pin, HIGH, bounce_us);
+}
+
+const sim_isr_stats &sim_isr_get_stats(uint8_t pin) {
+    return isr_stats[pin];
+}
+
+void sim_isr_reset_stats(void) {
+    memset(isr_stats, 0, sizeof(isr_stats));
+}
+
+/* I2C */
+void TwoWire::begin(void) {
+}
+
+void TwoWire::begin(int sda, int scl) {
+    (void)sda;
+    (void)scl;
+}
+
+void TwoWire::setClock(uint32_t hz) {
+    i2c_hz = hz;
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+    i2c_current.time_us = static_cast<uint32_t>(now_us);
+    i2c_current.addr = addr;
+    i2c_current.bytes.clear();
+}
+
+size_t TwoWire::write(uint8_t data) {
+    i2c_current.bytes.push_back(data);
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t len) {
+    i2c_current.bytes.insert(i2c_current.bytes.end(), data, data + len);
+    return len;
+}
+
+/* Nine clocks per byte plus start and stop */
+uint8_t TwoWire::endTransmission(bool stop) {
+    uint32_t bits = (1 + i2c_current.bytes.size()) * 9 + 2;
+
+    (void)stop;
+    i2c_bytes += 1 + i2c_current.bytes.size();
+    sim_advance_us(static_cast<uint64_t>(bits) * 1000000U / i2c_hz);
+    i2c_current.end_us = static_cast<uint32_t>(now_us);
+    i2c_log.push_back(i2c_current);
+    return 0;
+}
+
+void sim_i2c_set_clock(uint32_t hz) {
+    i2c_hz = hz;
+}
+
+const std::vector<sim_i2c_transaction> &sim_i2c_log(void) {
+    return i2c_log;
+}
+
+void sim_i2c_clear(void) {
+    i2c_log.clear();
+    i2c_bytes = 0;
+}
+
+uint32_t sim_i2c_bytes(void) {
+    return i2c_bytes;
+}
+
+/* Serial */
+size_t Print::write(const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        write(buf[i]);
+    }
+    return len;
+}
+
+size_t Print::print(const char *str) {
+    return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+}
+
+size_t Print::print(char c) {
+    return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(int value) {
+    return print(static_cast<long>(value));
+}
+
+size_t Print::print(unsigned int value) {
+    return print(static_cast<unsigned long>(value));
+}
+
+size_t Print::print(long value) {
+    char str[24];
+    snprintf(str, sizeof(str), "%ld", value);
+    return print(str);
+}
+
+size_t Print::print(unsigned long value) {
+    char str[24];
+    snprintf(str, sizeof(str), "%lu", value);
+    return print(str);
+}
+
+size_t Print::print(double value, int digits) {
+    char str[40];
+    snprintf(str, sizeof(str), "%.*f", digits, value);
+    return print(str);
+}
+
+size_t Print::println(void) {
+    return print("\r\n");
+}
+
+void HostSerial::begin(unsigned long baud) {
+    (void)baud;
+}
+
+int HostSerial::available(void) {
+    return static_cast<int>(serial_rx.size() - serial_rx_pos);
+}
+
+int HostSerial::availableForWrite(void) {
+    return 64;
+}
+
+int HostSerial::read(void) {
+    if (serial_rx_pos >= serial_rx.size()) {
+        return -1;
+    }
+    return serial_rx[serial_rx_pos++];
+}
+
+int HostSerial::peek(void) {
+    if (serial_rx_pos >= serial_rx.size()) {
+        return -1;
+    }
+    return serial_rx[serial_rx_pos];
+}
+
+size_t HostSerial::write(uint8_t c) {
+    serial_tx.push_back(c);
+    if (serial_echo) {
+        fputc(c, stdout);
+    }
+    return 1;
+}
+
+void sim_serial_inject(const uint8_t *data, size_t len) {
+    serial_rx.insert(serial_rx.end(), data, data + len);
+}
+
+void sim_serial_inject(const char *str) {
+    sim_serial_inject(reinterpret_cast<const uint8_t *>(str), strlen(str));
+}
+
+void sim_serial_echo(bool enable) {
+    serial_echo = enable;
+}
+
+const std::vector<uint8_t> &sim_serial_output(void) {
+    return serial_tx;
+}
+
+void sim_serial_clear(void) {
+    serial_tx.clear();
+}
+
+/* Flash */
+void sim_flash_wipe(void) {
+    memset(flash_mem, 0xFF, sizeof(flash_mem));
+    std::fill(flash_wear.begin(), flash_wear.end(), 0);
+    flash_tear = FLASH_WRITE_BYTES;
+    flash_ready = true;
+}
+
+/* A board starts out erased */
+static void flash_init(void) {
+    if (!flash_ready) {
+        sim_flash_wipe();
+    }
+}
+
+void sim_flash_read(uint32_t offset, void *data, size_t len) {
+    flash_init();
+    memcpy(data, &flash_mem[offset], len);
+    flash_stats.reads++;
+    flash_stats.read_bytes += len;
+}
+
+bool sim_flash_write(uint32_t offset, const void *data, size_t len) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    flash_init();
+    if (flash_off || offset + len > sizeof(flash_mem)) {
+        return false;
+    }
+    if (flash_tear < len) {
+        len = flash_tear;
+        flash_off = true;
+    }
+    flash_tear = FLASH_WRITE_BYTES;
+    for (size_t i = 0; i < len; ++i) {
+        flash_mem[offset + i] &= bytes[i];
+    }
+    flash_stats.writes++;
+    sim_advance_us(SIM_FLASH_WRITE_US);
+    return true;
+}
+
+void sim_flash_erase(uint32_t offset, size_t len) {
+    flash_init();
+    if (flash_off || offset + len > sizeof(flash_mem)) {
+        return;
+    }
+    memset(&flash_mem[offset], 0xFF, len);
+    flash_wear[offset / FLASH_BLOCK_BYTES]++;
+    flash_stats.erases++;
+    sim_advance_us(SIM_FLASH_ERASE_US);
+}
+
+void sim_flash_tear(size_t bytes) {
+    flash_tear = bytes;
+}
+
+const sim_flash_stats &sim_flash_get_stats(void) {
+    return flash_stats;
+}
+
+void sim_flash_reset_stats(void) {
+    memset(&flash_stats, 0, sizeof(flash_stats));
+}
+
+const std::vector<uint32_t> &sim_flash_wear(void) {
+    return flash_wear;
+}
@@ -0,0 +1,68 @@
+/*   hal.h - Control and inspection of the simulated board   */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Arduino.h"
+
+/* Host time spent in a pin interrupt handler */
+struct sim_isr_stats {
+    uint32_t calls;
+    uint32_t max_ns;
+    uint64_t total_ns;
+};
+
+struct sim_i2c_transaction {
+    uint32_t time_us;
+    uint32_t end_us;
+    uint8_t addr;
+    std::vector<uint8_t> bytes;
+};
+
+/* Sketch entry points */
+void setup(void);
+void loop(void);
+
+/* Virtual clock */
+void sim_reset(void);
+uint64_t sim_time_us(void);
+void sim_advance_us(uint64_t us);
+
+/* GPIO, a level change fires the attached interrupt */
+void sim_set_pin(uint8_t pin, uint8_t level);
+/* Quadrature steps on two pins, positive steps walk 00 01 11 10 */
+void sim_rotate(uint8_t pin_a, uint8_t pin_b, int steps, uint32_t edge_interval_us);
+/* Press and release a low-active button, optionally with contact bounce */
+void sim_press(uint8_t pin, uint32_t hold_ms, uint32_t bounce_us = 0);
+const sim_isr_stats &sim_isr_get_stats(uint8_t pin);
+void sim_isr_reset_stats(void);
+
+/* I2C */
+void sim_i2c_set_clock(uint32_t hz);
+const std::vector<sim_i2c_transaction> &sim_i2c_log(void);
+void sim_i2c_clear(void);
+uint32_t sim_i2c_bytes(void);
+
+/* Serial */
+void sim_serial_inject(const uint8_t *data, size_t len);
+void sim_serial_inject(const char *str);
+void sim_serial_echo(bool enable);
+const std::vector<uint8_t> &sim_serial_output(void);
+void sim_serial_clear(void);
+
+/* Flash, kept across sim_reset() so a reboot finds what was written */
+struct sim_flash_stats {
+    uint32_t reads;
+    uint32_t read_bytes;
+    uint32_t writes;
+    uint32_t erases;
+};
+
+void sim_flash_wipe(void);
+/* Power fails after the first bytes of the next write, flash is dead until sim_reset() */
+void sim_flash_tear(size_t bytes);
+const sim_flash_stats &sim_flash_get_stats(void);
+void sim_flash_reset_stats(void);
+/* Erase count of every block */
+const std::vector<uint32_t> &sim_flash_wear(void);
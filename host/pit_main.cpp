@@ -0,0 +1,62 @@
+/*   pit_main.cpp - Run the pit stop planner over the whole parameter space   */
+
+#include <stdio.h>
+#include <chrono>
+#include "pitOptimizer.h"
+#include "fuelMeter.h"
+
+#define TANK_STEP       10
+#define PIT_LOSS_STEP   10
+
+static uint64_t now_ns(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(void) {
+    unsigned long plans = 0;
+    unsigned long infeasible = 0;
+    unsigned long incomplete = 0;
+    unsigned long stops[PIT_MAX_STOPS + 1] = {};
+    unsigned worst_steps = 0;
+    uint64_t total_steps = 0;
+    uint64_t total_ns = 0;
+    pit_plan plan;
+
+    for (uint8_t warmup = 0; warmup <= 1; ++warmup) {
+        for (unsigned race_length = cMIN_RACE_REMAINING; race_length <= cMAX_RACE_REMAINING; ++race_length) {
+            for (unsigned laptime = cMIN_LAPTIME; laptime <= cMAX_LAPTIME; ++laptime) {
+                for (unsigned consumption = cMIN_FUEL_CUNSUMPTION; consumption <= cMAX_FUEL_CUNSUMPTION; ++consumption) {
+                    for (unsigned tank = cMIN_TANK_CAPACITY; tank <= cMAX_TANK_CAPACITY; tank += TANK_STEP) {
+                        for (unsigned pit_loss = cMIN_PIT_LOSS; pit_loss <= cMAX_PIT_LOSS; pit_loss += PIT_LOSS_STEP) {
+                            uint64_t start = now_ns();
+                            bool found = plan_pit_stops(warmup, race_length, laptime, consumption, tank, pit_loss, plan);
+
+                            total_ns += now_ns() - start;
+                            plans++;
+                            total_steps += plan.steps;
+                            if (plan.steps > worst_steps) {
+                                worst_steps = plan.steps;
+                            }
+                            incomplete += !plan.complete;
+                            if (found) {
+                                stops[plan.stops]++;
+                            } else {
+                                infeasible++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%lu plans, %lu need more than %d stops, %lu hit the step budget\n", plans, infeasible, PIT_MAX_STOPS, incomplete);
+    for (int i = 0; i <= PIT_MAX_STOPS; ++i) {
+        printf("  %d stops: %lu\n", i, stops[i]);
+    }
+    // Wall time per plan is noisy on a desktop, the step count is what bounds the target
+    printf("steps mean %.1f, worst %u of %d, time mean %.0f ns\n", static_cast<double>(total_steps) / plans,
+           worst_steps, PIT_SEARCH_STEPS, static_cast<double>(total_ns) / plans);
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*   protocol_main.cpp - Fuzz and round trip checks of the binary telemetry protocol   */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "hal.h"
+#include "telemetry.h"
+
+#define COBS_ROUNDS     200000
+#define GARBAGE_ROUNDS  20000
+#define MIXED_ROUNDS    20000
+#define STREAM_UPDATES  1000
+
+/* Zeros are what COBS has to get right, so a third of the bytes are zero */
+static uint8_t random_byte(void) {
+    return (rand() % 3 == 0) ? 0x00 : static_cast<uint8_t>(rand());
+}
+
+static fuel_packet random_fuel(void) {
+    fuel_packet packet;
+
+    packet.fuel_remaining = static_cast<uint16_t>(rand());
+    packet.fuel_per_lap = static_cast<uint16_t>(rand());
+    packet.consumption = static_cast<uint16_t>(rand());
+    packet.laps_remaining = static_cast<uint16_t>(rand());
+    return packet;
+}
+
+static bool same(const fuel_packet &a, const fuel_packet &b) {
+    return a.fuel_remaining == b.fuel_remaining && a.fuel_per_lap == b.fuel_per_lap &&
+           a.consumption == b.consumption && a.laps_remaining == b.laps_remaining;
+}
+
+static void feed(Telemetry &telemetry, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        telemetry.feed(data[i], 0);
+        // Drained like the sketch does, so a full ring never hides a frame
+        while (telemetry.front() != nullptr) {
+            telemetry.release();
+        }
+    }
+}
+
+/* Encoded blocks have no zeros and decode to the input, garbage stays in bounds */
+static unsigned cobs(void) {
+    unsigned errors = 0;
+
+    for (int round = 0; round < COBS_ROUNDS; ++round) {
+        size_t len = static_cast<size_t>(rand() % 600);
+        std::vector<uint8_t> in(len + 1);
+        std::vector<uint8_t> encoded(len + len / 254 + 1);
+        std::vector<uint8_t> decoded(len + 1);
+
+        for (size_t i = 0; i < len; ++i) {
+            in[i] = random_byte();
+        }
+        size_t encoded_len = cobs_encode(in.data(), len, encoded.data());
+        if (encoded_len > encoded.size() || memchr(encoded.data(), 0x00, encoded_len) != nullptr ||
+            cobs_decode(encoded.data(), encoded_len, decoded.data()) != len ||
+            memcmp(in.data(), decoded.data(), len) != 0) {
+            errors++;
+        }
+
+        // Any block decodes to at most its own length
+        for (size_t i = 0; i < len; ++i) {
+            in[i] = random_byte();
+        }
+        if (cobs_decode(in.data(), len, decoded.data()) > len) {
+            errors++;
+        }
+    }
+    printf("cobs: %d round trips and garbage blocks, %u errors\n", COBS_ROUNDS, errors);
+    return errors;
+}
+
+/* Random text and binary garbage, then a good frame that must come through */
+static unsigned garbage(void) {
+    unsigned errors = 0;
+    unsigned decoded = 0;
+
+    for (int round = 0; round < GARBAGE_ROUNDS; ++round) {
+        Telemetry telemetry;
+        uint8_t noise[64];
+        uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+        fuel_packet packet = random_fuel();
+        size_t noise_len = static_cast<size_t>(rand() % sizeof(noise));
+
+        for (size_t i = 0; i < noise_len; ++i) {
+            // Tags, terminators and delimiters drive the parser through every state
+            static const uint8_t specials[] = {0x00, ';', 'T', 'U', 'C', 'L', '\n'};
+            noise[i] = (rand() % 4 == 0) ? specials[rand() % sizeof(specials)] : static_cast<uint8_t>(rand());
+        }
+        feed(telemetry, noise, noise_len);
+        feed(telemetry, frame, encode_fuel_frame(packet, frame));
+        if (same(telemetry.fuel(), packet)) {
+            decoded++;
+        } else {
+            errors++;
+        }
+    }
+    printf("garbage: %d streams, %u good frames recovered, %u errors\n", GARBAGE_ROUNDS, decoded, errors);
+    return errors;
+}
+
+/* Text after a binary frame, on a new line or not, then frames sharing a delimiter */
+static unsigned mixed(void) {
+    static const char *const breaks[] = {"", "\n", "\r\n"};
+    unsigned errors = 0;
+
+    for (int round = 0; round < MIXED_ROUNDS; ++round) {
+        Telemetry telemetry;
+        uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+        fuel_packet first = random_fuel();
+        fuel_packet second = random_fuel();
+        char text[16];
+        size_t len;
+
+        feed(telemetry, frame, encode_fuel_frame(first, frame));
+        len = static_cast<size_t>(snprintf(text, sizeof(text), "%sT%d;", breaks[round % 3], round % 100));
+        for (size_t i = 0; i < len; ++i) {
+            telemetry.feed(static_cast<uint8_t>(text[i]), 0);
+        }
+        telemetry_frame *received = telemetry.front();
+        if (received == nullptr) {
+            errors++;
+        } else {
+            errors += received->tag != 'T' || received->numeric;
+            telemetry.release();
+        }
+
+        // Back to back, the second frame keeps its opening delimiter only
+        // when its first code reads as a line break
+        feed(telemetry, frame, encode_fuel_frame(first, frame));
+        len = encode_fuel_frame(second, frame);
+        if (frame[1] == '\r' || frame[1] == '\n') {
+            feed(telemetry, frame, len);
+        } else {
+            feed(telemetry, frame + 1, len - 1);
+        }
+        if (!same(telemetry.fuel(), second)) {
+            errors++;
+        }
+    }
+    printf("mixed: %d binary frames followed by text and by a frame, %u errors\n", MIXED_ROUNDS, errors);
+    return errors;
+}
+
+/* CRC-8 catches every single bit error, in the payload and in the COBS codes */
+static unsigned bit_flips(void) {
+    unsigned errors = 0;
+    unsigned flips = 0;
+
+    for (int round = 0; round < 100; ++round) {
+        uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+        fuel_packet packet = random_fuel();
+        size_t len = encode_fuel_frame(packet, frame);
+
+        // The delimiters are left alone, a flipped one is a different frame length
+        for (size_t byte = 1; byte < len - 1; ++byte) {
+            for (int bit = 0; bit < 8; ++bit) {
+                Telemetry telemetry;
+                uint8_t flipped[TELEMETRY_MAX_FRAME + 2];
+
+                memcpy(flipped, frame, len);
+                flipped[byte] ^= static_cast<uint8_t>(1U << bit);
+                feed(telemetry, flipped, len);
+                flips++;
+                if (telemetry.get_stats().frames != 0) {
+                    errors++;
+                }
+            }
+        }
+    }
+    printf("bit flips: %u single bit errors, %u accepted\n", flips, errors);
+    return errors;
+}
+
+/*
+ * Wire bytes per update for a race, binary frames back to back so they
+ * share delimiters where they can. The text has the three values it can
+ * carry, U, C and L.
+ */
+static void wire_bytes(void) {
+    unsigned long text_bytes = 0;
+    unsigned long binary_bytes = 1;
+    char text[48];
+    uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+    fuel_packet packet;
+
+    for (int update = 0; update < STREAM_UPDATES; ++update) {
+        packet.fuel_remaining = static_cast<uint16_t>(6000 - update * 5);
+        packet.fuel_per_lap = static_cast<uint16_t>(280 + update % 11);
+        packet.consumption = static_cast<uint16_t>(285 + update % 7);
+        packet.laps_remaining = static_cast<uint16_t>(packet.fuel_remaining * 100U / packet.consumption);
+        text_bytes += static_cast<unsigned long>(snprintf(text, sizeof(text), "U%u.%02u;C%u.%02u;L%u.%02u;",
+            packet.fuel_per_lap / 100U, packet.fuel_per_lap % 100U, packet.consumption / 100U,
+            packet.consumption % 100U, packet.laps_remaining / 100U, packet.laps_remaining % 100U));
+        size_t len = encode_fuel_frame(packet, frame);
+        // A first code that reads as a line break keeps its opening delimiter
+        binary_bytes += len - ((frame[1] == '\r' || frame[1] == '\n') ? 0 : 1);
+    }
+    printf("wire bytes: text %.1f per update for 3 values, binary %.1f for 4 values, %.2fx less per value\n",
+           static_cast<double>(text_bytes) / STREAM_UPDATES, static_cast<double>(binary_bytes) / STREAM_UPDATES,
+           (text_bytes / 3.0) / (binary_bytes / 4.0));
+}
+
+int main(void) {
+    unsigned errors = 0;
+
+    sim_reset();
+    errors += cobs();
+    errors += garbage();
+    errors += mixed();
+    errors += bit_flips();
+    wire_bytes();
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*   settings_main.cpp - Wear, power cut and batching checks of the settings log   */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "hal.h"
+#include "settings.h"
+
+#define WEAR_SAVES      20000
+
+static settings random_settings(void) {
+    settings values;
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(&values);
+
+    for (size_t i = 0; i < sizeof(values); ++i) {
+        bytes[i] = static_cast<uint8_t>(rand());
+    }
+    return values;
+}
+
+static bool same(const settings &a, const settings &b) {
+    return memcmp(&a, &b, sizeof(settings)) == 0;
+}
+
+/* A fresh store, as after a power cycle */
+static bool reboot(SettingsStore &store, settings &values) {
+    sim_reset();
+    store = SettingsStore();
+    memset(&values, 0, sizeof(values));
+    return store.load(values);
+}
+
+/* Every save must be the one a reboot finds, erases spread over all blocks */
+static unsigned wear(void) {
+    SettingsStore store;
+    settings values = {};
+    settings loaded;
+    unsigned errors = 0;
+    uint32_t now_ms = 0;
+
+    sim_flash_wipe();
+    sim_flash_reset_stats();
+    store.load(values);
+    for (int i = 0; i < WEAR_SAVES; ++i) {
+        values = random_settings();
+        store.update(values, now_ms);
+        now_ms += cSETTINGS_IDLE_MS;
+        if (!store.service(now_ms)) {
+            errors++;
+        }
+        if (i % 7 == 0 && (!reboot(store, loaded) || !same(loaded, values))) {
+            errors++;
+        }
+    }
+
+    // The log is at the start of the flash, the profile tables follow it
+    const std::vector<uint32_t> &blocks = sim_flash_wear();
+    const unsigned log_blocks = FLASH_LOG_BYTES / FLASH_BLOCK_BYTES;
+    uint32_t least = blocks[0];
+    uint32_t most = blocks[0];
+    for (unsigned i = 0; i < log_blocks; ++i) {
+        least = blocks[i] < least ? blocks[i] : least;
+        most = blocks[i] > most ? blocks[i] : most;
+    }
+    printf("wear: %d saves, %u page writes, %u blocks erased %u to %u times, %u errors\n",
+           WEAR_SAVES, static_cast<unsigned>(sim_flash_get_stats().writes), log_blocks,
+           static_cast<unsigned>(least), static_cast<unsigned>(most), errors);
+    return errors;
+}
+
+/* Cut power part way through a record at every slot and every length */
+static unsigned power_cut(void) {
+    SettingsStore store;
+    settings old_values;
+    settings new_values;
+    settings loaded;
+    unsigned errors = 0;
+    unsigned cuts = 0;
+    uint32_t now_ms = 0;
+
+    // A log with a record in it, so there is something to fall back to
+    sim_flash_wipe();
+    reboot(store, old_values);
+    store.update(random_settings(), now_ms);
+    now_ms += cSETTINGS_IDLE_MS;
+    store.service(now_ms);
+    for (unsigned slot = 0; slot < SETTINGS_SLOTS + 3; ++slot) {
+        for (unsigned bytes = 0; bytes < SETTINGS_RECORD_BYTES; ++bytes) {
+            reboot(store, old_values);
+            new_values = random_settings();
+            store.update(new_values, now_ms);
+            now_ms += cSETTINGS_IDLE_MS;
+            sim_flash_tear(bytes);
+            store.service(now_ms);
+            cuts++;
+            // The torn record is ignored, the one before it is still current
+            if (!reboot(store, loaded) || !same(loaded, old_values)) {
+                errors++;
+            }
+            // The next save goes past the torn slot
+            new_values = random_settings();
+            store.update(new_values, now_ms);
+            now_ms += cSETTINGS_IDLE_MS;
+            if (!store.service(now_ms) || !reboot(store, loaded) || !same(loaded, new_values)) {
+                errors++;
+            }
+        }
+    }
+    printf("power cut: %u torn records, %u errors\n", cuts, errors);
+    return errors;
+}
+
+/* An encoder spin is one record, a change that is undone none */
+static unsigned batching(void) {
+    SettingsStore store;
+    settings values = {};
+    unsigned errors = 0;
+    uint32_t now_ms = 0;
+
+    sim_flash_wipe();
+    store.load(values);
+    for (int step = 0; step < 200; ++step) {
+        values.laptime = static_cast<uint8_t>(80 + step % 70);
+        store.update(values, now_ms);
+        now_ms += 10;
+        store.service(now_ms);
+    }
+    now_ms += cSETTINGS_IDLE_MS;
+    store.service(now_ms);
+    unsigned spin_writes = store.get_stats().writes;
+
+    values.pit_loss = 40;
+    store.update(values, now_ms);
+    values.pit_loss = 0;
+    store.update(values, now_ms + 500);
+    store.service(now_ms + 500 + cSETTINGS_IDLE_MS);
+    if (spin_writes != 1 || store.get_stats().writes != 1 || store.get_stats().skipped != 1) {
+        errors++;
+    }
+    printf("batching: 200 steps in 2 s -> %u record, undone change -> %u skipped, %u errors\n",
+           spin_writes, static_cast<unsigned>(store.get_stats().skipped), errors);
+    return errors;
+}
+
+/* Boot reads the record bytes of every slot once */
+static void boot_scan(void) {
+    SettingsStore store;
+    settings loaded;
+
+    sim_flash_reset_stats();
+    reboot(store, loaded);
+    printf("boot scan: %u slots, %u reads, %u bytes\n", static_cast<unsigned>(store.get_stats().scan_slots),
+           static_cast<unsigned>(sim_flash_get_stats().reads), static_cast<unsigned>(sim_flash_get_stats().read_bytes));
+}
+
+int main(void) {
+    unsigned errors = 0;
+
+    sim_reset();
+    errors += wear();
+    boot_scan();
+    errors += power_cut();
+    errors += batching();
+    return errors == 0 ? 0 : 1;
+}
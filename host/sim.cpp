@@ -0,0 +1,262 @@
+/*   sim.cpp - Run the sketch against scripted input on the host   */
+
+#include <stdio.h>
+#include "hal.h"
+#include "oled.h"
+#include "fuelMeter.h"
+#include "telemetryProtocol.h"
+#include "power.h"
+#include "settings.h"
+#include "profiles.h"
+#include "gesture.h"
+
+#define SETTLE_MS       200
+/* Assumed SAMD21 core currents at 48 MHz, awake and in idle sleep */
+#define ACTIVE_MA       6.5
+#define IDLE_MA         2.5
+
+extern volatile displayMode mode;
+extern OLED oled;
+extern SettingsStore store;
+extern uint8_t laptime;
+extern uint8_t fuel_consumption;
+extern uint8_t race_length;
+void show_mode(void);
+
+static const char *mode_names[] = {
+    "None", "FuelTime", "FuelUsedLap", "FuelConsumption", "FuelLaps",
+    "CalcWarmup", "CalcRaceLength", "CalcLaptime", "CalcFuelConsumption",
+    "CalcFuelNeeded", "CalcLaps", "FuelStatus", "LiveFuelNeeded",
+    "CalcTankCapacity", "CalcPitLoss", "CalcPitStops", "LastMode", "ProfileSelect"
+};
+
+static uint32_t worst_latency_us;
+
+static void run_ms(uint32_t ms) {
+    uint64_t end = sim_time_us() + static_cast<uint64_t>(ms) * 1000U;
+
+    while (sim_time_us() < end) {
+        loop();
+    }
+}
+
+/* Let the sketch settle and report what the input cost on the bus */
+static uint32_t report(const char *what, uint64_t input_us) {
+    uint32_t bytes = 0;
+    uint32_t last_us = static_cast<uint32_t>(input_us);
+
+    run_ms(SETTLE_MS);
+    for (const sim_i2c_transaction &t : sim_i2c_log()) {
+        bytes += 1 + t.bytes.size();
+        last_us = t.end_us;
+    }
+    printf("%-34s %3u transactions %5u bytes, input to pixel %7.2f ms\n",
+           what, static_cast<unsigned>(sim_i2c_log().size()), static_cast<unsigned>(bytes),
+           (last_us - static_cast<uint32_t>(input_us)) / 1000.0);
+    sim_i2c_clear();
+    return last_us - static_cast<uint32_t>(input_us);
+}
+
+static void input_report(const char *what, uint64_t input_us) {
+    uint32_t latency_us = report(what, input_us);
+
+    if (latency_us > worst_latency_us) {
+        worst_latency_us = latency_us;
+    }
+}
+
+/*
+ * A short press shows on release, a long one while the button is still
+ * down, with a repeat every so often after it. Presses are kept a double
+ * click window apart so each one counts on its own.
+ */
+static void press(uint32_t hold_ms, uint32_t bounce_us = 0) {
+    char what[64];
+    uint64_t hold_us = static_cast<uint64_t>(hold_ms) * 1000U;
+    uint64_t input_us = sim_time_us() + hold_us;
+
+    if (hold_us >= cLONG_PRESS_US + cREPEAT_DELAY_US) {
+        input_us = sim_time_us() + hold_us - (hold_us - cLONG_PRESS_US - cREPEAT_DELAY_US) % cREPEAT_US;
+    } else if (hold_us >= cLONG_PRESS_US) {
+        input_us = sim_time_us() + cLONG_PRESS_US;
+    }
+    sim_press(BUTTON, hold_ms, bounce_us);
+    run_ms(hold_ms + (bounce_us + cDOUBLE_CLICK_US) / 1000U + 1);
+    snprintf(what, sizeof(what), "button -> %s", mode_names[static_cast<int>(mode)]);
+    input_report(what, input_us);
+}
+
+static void double_click(void) {
+    char what[64];
+
+    sim_press(BUTTON, 50);
+    run_ms(150);
+    uint64_t release_us = sim_time_us() + 50000U;
+    sim_press(BUTTON, 50);
+    run_ms(51 + cDEBOUNCE_US / 1000U);
+    snprintf(what, sizeof(what), "double click -> %s", mode_names[static_cast<int>(mode)]);
+    input_report(what, release_us);
+}
+
+static void isr_report(const char *what, uint8_t pin_a, uint8_t pin_b) {
+    const sim_isr_stats &a = sim_isr_get_stats(pin_a);
+    const sim_isr_stats &b = sim_isr_get_stats(pin_b);
+    uint32_t calls = a.calls + b.calls;
+
+    printf("%s interrupt %u calls, worst %u ns, mean %u ns of host time\n", what, static_cast<unsigned>(calls),
+           static_cast<unsigned>(a.max_ns > b.max_ns ? a.max_ns : b.max_ns),
+           static_cast<unsigned>(calls > 0 ? (a.total_ns + b.total_ns) / calls : 0));
+}
+
+static void rotate(int steps, uint32_t edge_interval_us) {
+    char what[64];
+    uint64_t input_us = sim_time_us();
+
+    sim_rotate(ROT1_CLK, ROT1_DAT, steps, edge_interval_us);
+    snprintf(what, sizeof(what), "rotate %+d edges @ %u us", steps, static_cast<unsigned>(edge_interval_us));
+    input_report(what, input_us);
+}
+
+static void telemetry(const char *msg) {
+    char what[64];
+    uint64_t input_us = sim_time_us();
+
+    sim_serial_inject(msg);
+    snprintf(what, sizeof(what), "telemetry \"%s\"", msg);
+    input_report(what, input_us);
+}
+
+static void telemetry(const fuel_packet &packet) {
+    uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+    size_t len = encode_fuel_frame(packet, frame);
+    char what[64];
+    uint64_t input_us = sim_time_us();
+
+    sim_serial_inject(frame, len);
+    snprintf(what, sizeof(what), "telemetry binary, %u bytes", static_cast<unsigned>(len));
+    input_report(what, input_us);
+}
+
+static void telemetry(const lap_packet &packet) {
+    uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+    size_t len = encode_lap_frame(packet, frame);
+    char what[64];
+    uint64_t input_us = sim_time_us();
+
+    sim_serial_inject(frame, len);
+    snprintf(what, sizeof(what), "lap %u, %u bytes", static_cast<unsigned>(packet.lap), static_cast<unsigned>(len));
+    input_report(what, input_us);
+}
+
+/* Two cars on two tracks, the whole blob at once */
+static void upload_profiles(void) {
+    static const char *const cars[] = {"GT3R", "GT4"};
+    static const char *const tracks[] = {"MONZA", "SPA"};
+    static const profile entries[] = {
+        {0, 0, 107, 31, 60, 1},
+        {0, 1, 138, 36, 45, 0},
+        {1, 0, 115, 26, 30, 0},
+    };
+    uint8_t blob[PROFILE_BLOB_BYTES(2, 2, 3)];
+    uint8_t frames[TELEMETRY_BLOB_FRAMES_BYTES(sizeof(blob))];
+    size_t len = encode_profile_blob(cars, 2, tracks, 2, entries, 3, blob);
+    size_t bytes = encode_blob_frames(blob, len, frames);
+    char what[64];
+    uint64_t input_us = sim_time_us();
+
+    sim_serial_inject(frames, bytes);
+    snprintf(what, sizeof(what), "profiles, %u byte blob in %u bytes", static_cast<unsigned>(len), static_cast<unsigned>(bytes));
+    input_report(what, input_us);
+}
+
+static void wait(uint32_t ms, const char *what) {
+    uint64_t input_us = sim_time_us();
+
+    run_ms(ms);
+    report(what, input_us);
+}
+
+/* The serial output, a binary trace when built with TRACE_LEVEL, goes to argv[1] */
+int main(int argc, char **argv) {
+    sim_reset();
+    sim_isr_reset_stats();
+    setup();
+    report("boot", 0);
+
+    // Into the calculator, then every calculator page, the first press bounces
+    press(50, 3000);
+    rotate(2, 2000);
+    press(50);
+    rotate(2, 2000);
+    rotate(-2, 2000);
+    press(50);
+    rotate(2, 2000);
+    rotate(40, 1000);
+    press(50);
+    rotate(-8, 5000);
+    press(50);
+    press(50);
+
+    // The profile menu fills when a table arrives, a profile sets all four inputs in one repaint
+    press(1200, 3000);
+    upload_profiles();
+    rotate(2, 2000);
+    uint32_t frames = oled.get_stats().frames;
+    press(50);
+    printf("profile applied in %u frame(s)\n", static_cast<unsigned>(oled.get_stats().frames - frames));
+
+    // Holding on after the menu opens scrolls it, a double click goes back a page
+    press(1700);
+    press(50);
+    double_click();
+
+    // Live SimHub data on a telemetry page, then the link drops
+    mode = displayMode::FuelLaps;
+    show_mode();
+    wait(0, "show FuelLaps");
+    telemetry("L12.3;");
+    telemetry("L12.2;T1:02;");
+    telemetry(fuel_packet {4520, 285, 291, 1532});
+
+    // Fuel needed follows the laps as they complete
+    mode = displayMode::LiveFuelNeeded;
+    show_mode();
+    wait(0, "show LiveFuelNeeded");
+    telemetry(lap_packet {1, 291, 10412});
+    telemetry(lap_packet {2, 285, 10236});
+    telemetry(lap_packet {3, 288, 10301});
+    wait(6000, "6 s without telemetry");
+
+    double awake = 1.0 - static_cast<double>(power_sleep_us()) / sim_time_us();
+    printf("worst input to pixel %.2f ms, awake %.1f %% of %.1f s, estimated %.2f mA\n",
+           worst_latency_us / 1000.0, awake * 100.0, sim_time_us() / 1e6,
+           awake * ACTIVE_MA + (1.0 - awake) * IDLE_MA);
+    printf("frames rendered %u, refreshes folded into a pending frame %u\n",
+           static_cast<unsigned>(oled.get_stats().frames), static_cast<unsigned>(oled.get_stats().skipped));
+    isr_report("button", BUTTON, BUTTON);
+    isr_report("encoder", ROT1_CLK, ROT1_DAT);
+
+    if (argc > 1) {
+        FILE *f = fopen(argv[1], "wb");
+        if (f == nullptr) {
+            perror(argv[1]);
+            return 1;
+        }
+        fwrite(sim_serial_output().data(), 1, sim_serial_output().size(), f);
+        fclose(f);
+    }
+
+    // Power cycle, the calculator inputs come back from flash
+    const settings_stats &saved = store.get_stats();
+    printf("settings %u records, %u erases, %u changes undone\n",
+           static_cast<unsigned>(saved.writes), static_cast<unsigned>(saved.erases), static_cast<unsigned>(saved.skipped));
+    sim_reset();
+    sim_flash_reset_stats();
+    store = SettingsStore();
+    setup();
+    report("reboot", 0);
+    printf("restored race %u min, laptime %u s, %u.%u l/lap from %u slots, %u bytes read\n",
+           race_length, laptime, fuel_consumption / 10U, fuel_consumption % 10U,
+           static_cast<unsigned>(store.get_stats().scan_slots), static_cast<unsigned>(sim_flash_get_stats().read_bytes));
+    return 0;
+}
@@ -0,0 +1,3 @@
+/*   sketch.cpp - The Arduino sketch built as plain C++   */
+
+#include "../fuelMeter.ino"
@@ -0,0 +1,211 @@
+/*   snapshot.cpp - Render every display mode to PBM images   */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "hal.h"
+#include "ssd1306.h"
+#include "oled.h"
+#include "fuelMeter.h"
+#include "telemetryProtocol.h"
+#include "profiles.h"
+
+#define SETTLE_MS       200
+
+extern volatile displayMode mode;
+extern uint8_t warmup;
+extern uint8_t race_length;
+extern bool custom_race_length;
+extern uint8_t laptime;
+extern uint8_t fuel_consumption;
+extern uint8_t tank_capacity;
+extern uint8_t pit_loss;
+void show_mode(void);
+void open_profile_menu(void);
+
+struct variant {
+    const char *name;
+    displayMode mode;
+    uint8_t warmup;
+    bool custom_race_length;
+    uint8_t race_length;
+    uint8_t laptime;
+    uint8_t fuel_consumption;
+};
+
+static const variant variants[] = {
+    {"fuel_time",           displayMode::FuelTime,            0, false, 20,  100, 30},
+    {"fuel_used_lap",       displayMode::FuelUsedLap,         0, false, 20,  100, 30},
+    {"fuel_consumption",    displayMode::FuelConsumption,     0, false, 20,  100, 30},
+    {"fuel_laps",           displayMode::FuelLaps,            0, false, 20,  100, 30},
+    {"warmup_no",           displayMode::CalcWarmup,          0, false, 20,  100, 30},
+    {"warmup_yes",          displayMode::CalcWarmup,          1, false, 20,  100, 30},
+    {"race_length",         displayMode::CalcRaceLength,      0, false, 20,  100, 30},
+    {"race_remaining",      displayMode::CalcRaceLength,      0, true,  7,   100, 30},
+    {"laptime_min",         displayMode::CalcLaptime,         0, false, 20,  80,  30},
+    {"laptime_max",         displayMode::CalcLaptime,         0, false, 20,  150, 30},
+    {"consumption_min",     displayMode::CalcFuelConsumption, 0, false, 20,  100, 20},
+    {"consumption_max",     displayMode::CalcFuelConsumption, 0, false, 20,  100, 45},
+    {"fuel_needed",         displayMode::CalcFuelNeeded,      1, false, 120, 80,  45},
+    {"fuel_needed_short",   displayMode::CalcFuelNeeded,      0, true,  0,   150, 20},
+    {"laps",                displayMode::CalcLaps,            1, false, 120, 80,  45},
+    {"laps_short",          displayMode::CalcLaps,            0, false, 15,  150, 20},
+};
+
+static SSD1306 model(OLED_ADDRESS);
+
+static void settle(void) {
+    uint64_t end = sim_time_us() + SETTLE_MS * 1000U;
+
+    while (sim_time_us() < end) {
+        loop();
+    }
+    model.feed(sim_i2c_log());
+    sim_i2c_clear();
+}
+
+/* Write the image, or compare it against the reference when given */
+static bool snapshot(const char *out_dir, const char *ref_dir, int index, const char *name) {
+    char file[64];
+    std::string path;
+    std::string image = model.pbm();
+
+    snprintf(file, sizeof(file), "%02d_%s.pbm", index, name);
+    path = std::string(out_dir) + "/" + file;
+    if (!model.write_pbm(path.c_str())) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+    if (ref_dir == nullptr) {
+        return true;
+    }
+
+    std::string ref;
+    char chunk[512];
+    size_t n;
+    FILE *f = fopen((std::string(ref_dir) + "/" + file).c_str(), "r");
+    if (f == nullptr) {
+        fprintf(stderr, "%s: no reference image\n", file);
+        return false;
+    }
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        ref.append(chunk, n);
+    }
+    fclose(f);
+    if (ref != image) {
+        fprintf(stderr, "%s: differs from reference\n", file);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const char *out_dir = nullptr;
+    const char *ref_dir = nullptr;
+    int failed = 0;
+    int index = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) {
+            ref_dir = argv[++i];
+        } else {
+            out_dir = argv[i];
+        }
+    }
+    if (out_dir == nullptr) {
+        fprintf(stderr, "usage: %s <out_dir> [--check <reference_dir>]\n", argv[0]);
+        return 2;
+    }
+
+    sim_reset();
+    setup();
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "boot");
+
+    for (const variant &v : variants) {
+        mode = v.mode;
+        warmup = v.warmup;
+        custom_race_length = v.custom_race_length;
+        race_length = v.race_length;
+        laptime = v.laptime;
+        fuel_consumption = v.fuel_consumption;
+        show_mode();
+        settle();
+        failed += !snapshot(out_dir, ref_dir, index++, v.name);
+    }
+
+    // Dashboard page fed by one binary telemetry packet
+    uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+    mode = displayMode::FuelStatus;
+    show_mode();
+    sim_serial_inject(frame, encode_fuel_frame(fuel_packet {4520, 285, 291, 1532}, frame));
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "fuel_status");
+
+    // Live fuel needed for a 30 minute race after three laps
+    static const lap_packet laps[] = {{1, 291, 10412}, {2, 285, 10236}, {3, 288, 10301}};
+    mode = displayMode::LiveFuelNeeded;
+    race_length = 30;
+    show_mode();
+    for (const lap_packet &lap : laps) {
+        sim_serial_inject(frame, encode_lap_frame(lap, frame));
+    }
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "live_fuel_needed");
+
+    // Pit stop planner inputs and plans for a long and a short race
+    static const struct {
+        const char *name;
+        displayMode mode;
+        uint8_t race_length;
+    } pit_pages[] = {
+        {"tank_capacity",   displayMode::CalcTankCapacity, 120},
+        {"pit_loss",        displayMode::CalcPitLoss,      120},
+        {"pit_stops",       displayMode::CalcPitStops,     120},
+        {"pit_stops_none",  displayMode::CalcPitStops,     20},
+    };
+    warmup = 1;
+    laptime = 100;
+    fuel_consumption = 30;
+    tank_capacity = 120;
+    pit_loss = 30;
+    for (const auto &page : pit_pages) {
+        mode = page.mode;
+        race_length = page.race_length;
+        show_mode();
+        settle();
+        failed += !snapshot(out_dir, ref_dir, index++, page.name);
+    }
+
+    // Profile menu before and after a table arrives
+    static const char *const cars[] = {"GT3R"};
+    static const char *const tracks[] = {"NORDSCHL"};
+    static const profile entries[] = {{0, 0, 150, 45, 120, 1}};
+    uint8_t blob[PROFILE_BLOB_BYTES(1, 1, 1)];
+    uint8_t frames[TELEMETRY_BLOB_FRAMES_BYTES(sizeof(blob))];
+    mode = displayMode::CalcWarmup;
+    open_profile_menu();
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "profiles_none");
+    sim_serial_inject(frames, encode_blob_frames(blob, encode_profile_blob(cars, 1, tracks, 1, entries, 1, blob), frames));
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "profile_select");
+
+    // Dashboard numbers too wide for their cell lose decimals
+    mode = displayMode::FuelStatus;
+    show_mode();
+    sim_serial_inject(frame, encode_fuel_frame(fuel_packet {65000, 285, 291, 10012}, frame));
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "fuel_status_wide");
+
+    // A tank so small the race needs more stops than the planner tries
+    mode = displayMode::CalcPitStops;
+    race_length = 120;
+    tank_capacity = 10;
+    show_mode();
+    settle();
+    failed += !snapshot(out_dir, ref_dir, index++, "pit_stops_over");
+
+    printf("%d images, %d failed\n", index, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+/*   ssd1306.cpp - SSD1306 model decoding captured I2C traffic   */
+
+#include <stdio.h>
+#include <string.h>
+#include "ssd1306.h"
+
+#define CONTROL_CMD     0x00
+#define CONTROL_DATA    0x40
+
+#define MODE_HORIZONTAL 0
+#define MODE_VERTICAL   1
+#define MODE_PAGE       2
+
+SSD1306::SSD1306(uint8_t addr, uint8_t height) : m_addr(addr), m_height(height) {
+    memset(m_ram, 0, sizeof(m_ram));
+    m_mode = MODE_PAGE;
+    m_col = 0;
+    m_page = 0;
+    m_col_start = 0;
+    m_col_end = SSD1306_COLUMNS - 1;
+    m_page_start = 0;
+    m_page_end = SSD1306_PAGES - 1;
+    m_seg_remap = false;
+    m_com_remap = false;
+    m_inverted = false;
+}
+
+/* Command byte plus its parameters */
+size_t SSD1306::command_length(uint8_t cmd) {
+    switch (cmd) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 2;
+        case 0x21: case 0x22: case 0xA3:
+            return 3;
+        case 0x29: case 0x2A:
+            return 6;
+        case 0x26: case 0x27:
+            return 7;
+        default:
+            return 1;
+    }
+}
+
+void SSD1306::feed(const sim_i2c_transaction &t) {
+    if (t.addr != m_addr || t.bytes.empty()) {
+        return;
+    }
+
+    if (t.bytes[0] == CONTROL_DATA) {
+        for (size_t i = 1; i < t.bytes.size(); ++i) {
+            data(t.bytes[i]);
+        }
+    } else if (t.bytes[0] == CONTROL_CMD) {
+        size_t i = 1;
+        while (i < t.bytes.size()) {
+            size_t len = command_length(t.bytes[i]);
+            if (i + len > t.bytes.size()) {
+                break;
+            }
+            command(&t.bytes[i], len);
+            i += len;
+        }
+    }
+}
+
+void SSD1306::feed(const std::vector<sim_i2c_transaction> &log) {
+    for (const sim_i2c_transaction &t : log) {
+        feed(t);
+    }
+}
+
+void SSD1306::command(const uint8_t *cmd, size_t len) {
+    (void)len;
+    if (cmd[0] <= 0x0F) {
+        m_col = (m_col & 0xF0) | cmd[0];
+    } else if (cmd[0] <= 0x1F) {
+        m_col = (m_col & 0x0F) | ((cmd[0] & 0x0F) << 4);
+    } else if (cmd[0] >= 0xB0 && cmd[0] <= 0xB7) {
+        m_page = cmd[0] & 0x07;
+    } else {
+        switch (cmd[0]) {
+            case 0x20:
+                m_mode = cmd[1] & 0x03;
+                break;
+            case 0x21:
+                m_col_start = cmd[1] & 0x7F;
+                m_col_end = cmd[2] & 0x7F;
+                m_col = m_col_start;
+                break;
+            case 0x22:
+                m_page_start = cmd[1] & 0x07;
+                m_page_end = cmd[2] & 0x07;
+                m_page = m_page_start;
+                break;
+            case 0xA0:
+            case 0xA1:
+                m_seg_remap = cmd[0] & 0x01;
+                break;
+            case 0xC0:
+            case 0xC8:
+                m_com_remap = cmd[0] & 0x08;
+                break;
+            case 0xA6:
+            case 0xA7:
+                m_inverted = cmd[0] & 0x01;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void SSD1306::data(uint8_t byte) {
+    m_ram[m_page & 0x07][m_col & 0x7F] = byte;
+
+    if (m_mode == MODE_PAGE) {
+        m_col = (m_col + 1) & 0x7F;
+    } else if (m_mode == MODE_HORIZONTAL) {
+        if (m_col++ >= m_col_end) {
+            m_col = m_col_start;
+            m_page = (m_page >= m_page_end) ? m_page_start : m_page + 1;
+        }
+    } else {
+        if (m_page++ >= m_page_end) {
+            m_page = m_page_start;
+            m_col = (m_col >= m_col_end) ? m_col_start : m_col + 1;
+        }
+    }
+}
+
+/* Pixel as seen on the module, remapped segments and COMs are upright */
+bool SSD1306::pixel(uint8_t x, uint8_t y) const {
+    uint8_t col = m_seg_remap ? x : SSD1306_COLUMNS - 1 - x;
+    uint8_t row = m_com_remap ? y : m_height - 1 - y;
+    bool on = m_ram[row / 8][col] & (1 << (row % 8));
+
+    return on != m_inverted;
+}
+
+/* Plain PBM, one text line per pixel row so images diff well */
+std::string SSD1306::pbm(void) const {
+    std::string out = "P1\n" + std::to_string(SSD1306_COLUMNS) + " " + std::to_string(m_height) + "\n";
+
+    for (uint8_t y = 0; y < m_height; ++y) {
+        for (uint8_t x = 0; x < SSD1306_COLUMNS; ++x) {
+            out += pixel(x, y) ? '1' : '0';
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+bool SSD1306::write_pbm(const char *path) const {
+    FILE *f = fopen(path, "w");
+    std::string image = pbm();
+
+    if (f == nullptr) {
+        return false;
+    }
+    fwrite(image.data(), 1, image.size(), f);
+    return fclose(f) == 0;
+}
@@ -0,0 +1,43 @@
+/*   ssd1306.h - SSD1306 model decoding captured I2C traffic   */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "hal.h"
+
+#define SSD1306_COLUMNS 128
+#define SSD1306_PAGES   8
+
+/*
+ * Replays command and data transactions into a GDDRAM image, following
+ * the addressing modes and window commands the driver uses
+ */
+class SSD1306 {
+public:
+    explicit SSD1306(uint8_t addr, uint8_t height = 32);
+    void feed(const sim_i2c_transaction &t);
+    void feed(const std::vector<sim_i2c_transaction> &log);
+    bool pixel(uint8_t x, uint8_t y) const;
+    std::string pbm(void) const;
+    bool write_pbm(const char *path) const;
+
+private:
+    void command(const uint8_t *cmd, size_t len);
+    void data(uint8_t byte);
+    static size_t command_length(uint8_t cmd);
+
+    uint8_t m_addr;
+    uint8_t m_height;
+    uint8_t m_ram[SSD1306_PAGES][SSD1306_COLUMNS];
+    uint8_t m_mode;
+    uint8_t m_col;
+    uint8_t m_page;
+    uint8_t m_col_start;
+    uint8_t m_col_end;
+    uint8_t m_page_start;
+    uint8_t m_page_end;
+    bool m_seg_remap;
+    bool m_com_remap;
+    bool m_inverted;
+};
@@ -0,0 +1,122 @@
+/*   telemetry_main.cpp - Write binary fuel, lap or profile upload frames to stdout   */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetryProtocol.h"
+#include "profiles.h"
+
+/* Liters, laps and seconds to hundredths, clamped to the packet range */
+static uint16_t centi(const char *arg) {
+    double value = atof(arg) * 100.0 + 0.5;
+
+    if (value < 0.0) {
+        return 0;
+    }
+    return value > 65535.0 ? 65535 : static_cast<uint16_t>(value);
+}
+
+/* Index of name in the table, added if it isn't there yet */
+static int find_name(char (*names)[PROFILE_NAME_LEN + 1], uint8_t &count, uint8_t max, const char *name) {
+    for (uint8_t i = 0; i < count; ++i) {
+        if (strncmp(names[i], name, PROFILE_NAME_LEN) == 0) {
+            return i;
+        }
+    }
+    if (count == max) {
+        return -1;
+    }
+    snprintf(names[count], PROFILE_NAME_LEN + 1, "%s", name);
+    return count++;
+}
+
+/* car/track/laptime s or m:ss/consumption l/race min/warmup 0 or 1 */
+static bool parse_profile(char *spec, char (*cars)[PROFILE_NAME_LEN + 1], uint8_t &car_count,
+                          char (*tracks)[PROFILE_NAME_LEN + 1], uint8_t &track_count, profile &entry) {
+    char *fields[6];
+    int car;
+    int track;
+
+    for (int i = 0; i < 6; ++i) {
+        fields[i] = strtok(i == 0 ? spec : nullptr, "/");
+        if (fields[i] == nullptr) {
+            return false;
+        }
+    }
+    car = find_name(cars, car_count, PROFILE_MAX_CARS, fields[0]);
+    track = find_name(tracks, track_count, PROFILE_MAX_TRACKS, fields[1]);
+    if (car < 0 || track < 0) {
+        return false;
+    }
+    entry.car = static_cast<uint8_t>(car);
+    entry.track = static_cast<uint8_t>(track);
+    const char *colon = strchr(fields[2], ':');
+    entry.laptime = static_cast<uint8_t>(colon != nullptr ? atoi(fields[2]) * 60 + atoi(colon + 1) : atoi(fields[2]));
+    entry.fuel_consumption = static_cast<uint8_t>(atof(fields[3]) * 10.0 + 0.5);
+    entry.race_length = static_cast<uint8_t>(atoi(fields[4]));
+    entry.warmup = static_cast<uint8_t>(atoi(fields[5]) != 0);
+    return true;
+}
+
+/* The whole table as one blob, sent in consecutive chunk frames */
+static int write_profiles(int count, char **specs) {
+    char cars[PROFILE_MAX_CARS][PROFILE_NAME_LEN + 1];
+    char tracks[PROFILE_MAX_TRACKS][PROFILE_NAME_LEN + 1];
+    const char *car_names[PROFILE_MAX_CARS];
+    const char *track_names[PROFILE_MAX_TRACKS];
+    profile entries[PROFILE_MAX];
+    uint8_t car_count = 0;
+    uint8_t track_count = 0;
+    uint8_t blob[PROFILE_BLOB_BYTES(PROFILE_MAX_CARS, PROFILE_MAX_TRACKS, PROFILE_MAX)];
+    uint8_t frames[TELEMETRY_BLOB_FRAMES_BYTES(sizeof(blob))];
+    size_t len;
+
+    if (count > PROFILE_MAX) {
+        fprintf(stderr, "at most %d profiles\n", PROFILE_MAX);
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (!parse_profile(specs[i], cars, car_count, tracks, track_count, entries[i])) {
+            fprintf(stderr, "bad profile %d, or more than %d cars or tracks\n", i + 1, PROFILE_MAX_CARS);
+            return 1;
+        }
+    }
+    for (uint8_t i = 0; i < PROFILE_MAX_CARS; ++i) {
+        car_names[i] = cars[i];
+        track_names[i] = tracks[i];
+    }
+    len = encode_profile_blob(car_names, car_count, track_names, track_count, entries, static_cast<uint8_t>(count), blob);
+    len = encode_blob_frames(blob, len, frames);
+    return fwrite(frames, 1, len, stdout) == len ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    uint8_t frame[TELEMETRY_MAX_FRAME + 2];
+    size_t len;
+
+    if (argc > 2 && strcmp(argv[1], "--profiles") == 0) {
+        return write_profiles(argc - 2, &argv[2]);
+    } else if (argc == 5 && strcmp(argv[1], "--lap") == 0) {
+        lap_packet lap;
+
+        lap.lap = static_cast<uint16_t>(atoi(argv[2]));
+        lap.fuel_used = centi(argv[3]);
+        lap.laptime = centi(argv[4]);
+        len = encode_lap_frame(lap, frame);
+    } else if (argc == 5) {
+        fuel_packet packet;
+
+        packet.fuel_remaining = centi(argv[1]);
+        packet.fuel_per_lap = centi(argv[2]);
+        packet.consumption = centi(argv[3]);
+        packet.laps_remaining = centi(argv[4]);
+        len = encode_fuel_frame(packet, frame);
+    } else {
+        fprintf(stderr, "usage: %s <fuel remaining> <fuel per lap> <consumption> <laps remaining>\n", argv[0]);
+        fprintf(stderr, "       %s --lap <lap> <fuel used> <laptime s>\n", argv[0]);
+        fprintf(stderr, "       %s --profiles <car/track/laptime/consumption/race min/warmup>...\n", argv[0]);
+        return 1;
+    }
+
+    return fwrite(frame, 1, len, stdout) == len ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+/*   trace_main.cpp - Decode a binary trace from stdin   */
+
+#include <stdio.h>
+#include "trace.h"
+
+static const char *trace_names[] = {
+#define TRACE_ID_NAME(name) #name,
+    TRACE_IDS(TRACE_ID_NAME)
+#undef TRACE_ID_NAME
+};
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+int main(void) {
+    uint8_t record[TRACE_RECORD_BYTES];
+    unsigned long skipped = 0;
+    size_t len = 0;
+    int c;
+
+    while ((c = getchar()) != EOF) {
+        // Anything else on the port is skipped up to the next sync byte
+        if (len == 0 && c != TRACE_SYNC) {
+            skipped++;
+            continue;
+        }
+        record[len++] = static_cast<uint8_t>(c);
+        if (len == 2 && record[1] >= static_cast<uint8_t>(TraceId::Count)) {
+            skipped += 2;
+            len = 0;
+            continue;
+        }
+        if (len == TRACE_RECORD_BYTES) {
+            printf("%10.3f ms  %-16s %ld\n", get_u32(&record[2]) / 1000.0, trace_names[record[1]],
+                   static_cast<long>(static_cast<int32_t>(get_u32(&record[6]))));
+            len = 0;
+        }
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "%lu bytes outside trace records\n", skipped);
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+/* Compile-time index packs, 0 .. N-1 */
+template <size_t... I>
+struct index_list {};
+
+template <typename A, typename B>
+struct concat_index_list;
+
+template <size_t... A, size_t... B>
+struct concat_index_list<index_list<A...>, index_list<B...>> {
+    typedef index_list<A..., (sizeof...(A) + B)...> type;
+};
+
+/* Halving keeps the instantiation depth at log2(N) for large tables */
+template <size_t N>
+struct make_index_list : concat_index_list<typename make_index_list<N / 2>::type, typename make_index_list<N - N / 2>::type> {};
+
+template <>
+struct make_index_list<0> {
+    typedef index_list<> type;
+};
+
+template <>
+struct make_index_list<1> {
+    typedef index_list<0> type;
+};
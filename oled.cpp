@@ -66,6 +66,7 @@ void OLED::command_ssd1306(uint8_t addr, uint8_t cmd) {
   Wire.write(OLED_CMD);
   Wire.write(cmd);
   Wire.endTransmission();
+  count_transaction(2);
 }
 
 void OLED::command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t conf) {
@@ -74,6 +75,7 @@ void OLED::command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t conf) {
   Wire.write(cmd);
   Wire.write(conf);
   Wire.endTransmission();
+  count_transaction(3);
 }
 
 void OLED::command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t conf, uint8_t param) {
@@ -83,6 +85,7 @@ void OLED::command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t conf, uint8_t para
   Wire.write(conf);
   Wire.write(param);
   Wire.endTransmission();
+  count_transaction(4);
 }
 
 void OLED::command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e, uint8_t f) {
@@ -96,6 +99,15 @@ void OLED::command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t a, uint8_t b, uint
   Wire.write(e);
   Wire.write(f);
   Wire.endTransmission();
+  count_transaction(8);
+}
+
+void OLED::command_ssd1306(uint8_t addr, const uint8_t *cmds, uint8_t len) {
+  Wire.beginTransmission(addr);
+  Wire.write(OLED_CMD);
+  Wire.write(cmds, len);
+  Wire.endTransmission();
+  count_transaction(1 + len);
 }
 
 void OLED::write_data_ssd1306(uint8_t addr, uint8_t* data, uint32_t len) {
@@ -103,132 +115,235 @@ void OLED::write_data_ssd1306(uint8_t addr, uint8_t* data, uint32_t len) {
   Wire.write(OLED_DATA);
   Wire.write(data, len);
   Wire.endTransmission();
+  count_transaction(1 + len);
+}
+
+/* Send the next step of the latched frame: a window command or one data chunk */
+void OLED::send_chunk_ssd1306(uint8_t addr, uint8_t (*data)[COLUMNS]) {
+  struct oled_window *w = &windows[window_index];
+  uint32_t width = w->last_col - w->first_col + 1;
+  uint32_t total = (w->last_page - w->first_page + 1) * width;
+  uint32_t len;
+  uint32_t seg;
+
+  if(!window_started) {
+    const uint8_t window[] = {0x21, w->first_col, w->last_col, 0x22, w->first_page, w->last_page};
+    command_ssd1306(addr, window, sizeof(window));
+    window_started = true;
+    return;
+  }
+
+  len = total - window_sent;
+  if(len > OLED_I2C_CHUNK - 1) {
+    len = OLED_I2C_CHUNK - 1;
+  }
+  // Horizontal addressing mode wraps to the next page at the window edge
+  Wire.beginTransmission(addr);
+  Wire.write(OLED_DATA);
+  for(uint32_t done = 0; done < len; done += seg) {
+    uint32_t page = w->first_page + (window_sent + done) / width;
+    uint32_t col = w->first_col + (window_sent + done) % width;
+    seg = w->last_col - col + 1;
+    if(seg > len - done) {
+      seg = len - done;
+    }
+    Wire.write(&data[page][col], seg);
+  }
+  Wire.endTransmission();
+  count_transaction(1 + len);
+  window_sent += len;
+
+  if(window_sent == total) {
+    window_sent = 0;
+    window_started = false;
+    if(++window_index == num_windows) {
+      window_index = 0;
+      num_windows = 0;
+      stats.frames++;
+    }
+  }
+}
+
+void OLED::count_transaction(uint32_t len) {
+  stats.transactions++;
+  // Address byte is sent on every transaction
+  stats.bytes += 1 + len;
+}
+
+const struct oled_stats &OLED::get_stats(void) const {
+  return stats;
+}
+
+void OLED::reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
 }
 
 void OLED::start(void) {
   init_ssd1306(addr);
   init_display(COLUMNS, ROWS);
 
-  memset(display_buf, 0x00, COLUMNS*ROWS);
-  print_value(display_buf, "-");
-  print_header(display_buf, "   ACC FUEL METER   ", Alignment::Right);
-  print_unit(display_buf, UNIT_none);
-  update_ssd1306(addr, display_buf);
+  memset(display_buf, 0x00, sizeof(display_buf));
+  print_value(display_buf[0], "-", value_size);
+  print_header(display_buf[0], "   ACC FUEL METER   ", Alignment::Right);
+  print_unit(display_buf[0], unit, value_size);
+  // Display RAM content is unknown after power up
+  mark_all_dirty();
+  flush();
 }
 
-void OLED::update_ssd1306(uint8_t addr, uint32_t* data) {
-  // Start from page 0
-  command_ssd1306(addr, 0xB0);
-  // Start from column 0
-  command_ssd1306(addr, 0x00);
-  command_ssd1306(addr, 0x10);
-  int x = 0;
-  for(int i = 0; i < (COLUMNS)*(ROWS); i += 128) {
-    if (0x01 << x & new_content) {
-      command_ssd1306(addr, 0xB0 | x);
-      command_ssd1306(addr, 0x00);
-      command_ssd1306(addr, 0x10);
-      write_data_ssd1306(addr, ((uint8_t*)data)+i, 64);
-      write_data_ssd1306(addr, ((uint8_t*)data)+i+64, 64);
+/* Queue a window and copy its content to the transfer buffer */
+void OLED::add_window_ssd1306(uint8_t first_page, uint8_t last_page, uint8_t first_col, uint8_t last_col) {
+  struct oled_window *w = &windows[num_windows++];
+
+  w->first_page = first_page;
+  w->last_page = last_page;
+  w->first_col = first_col;
+  w->last_col = last_col;
+  for(uint8_t page = first_page; page <= last_page; ++page) {
+    memcpy(&transfer_buf[page][first_col], &display_buf[page][first_col], last_col - first_col + 1);
+  }
+}
+
+/* Latch the changed region of pages first..last for transfer */
+void OLED::latch_pages(uint8_t first, uint8_t last) {
+  uint8_t first_col;
+  uint8_t last_col;
+  uint8_t first_page = ROWS;
+  uint8_t last_page = 0;
+  uint8_t win_first = COLUMNS - 1;
+  uint8_t win_last = 0;
+  uint32_t page_cost = 0;
+  uint32_t window_cost;
+
+  for(uint8_t page = first; page <= last; ++page) {
+    if(!get_dirty(page, &first_col, &last_col)) {
+      continue;
+    }
+    if(first_page == ROWS) {
+      first_page = page;
+    }
+    last_page = page;
+    if(first_col < win_first) {
+      win_first = first_col;
+    }
+    if(last_col > win_last) {
+      win_last = last_col;
+    }
+    page_cost += OLED_WINDOW_COST + last_col - first_col + 1;
+  }
+  if(first_page == ROWS) {
+    return;
+  }
+
+  // One window around all changes unless it drags in too many clean bytes
+  window_cost = OLED_WINDOW_COST + (last_page - first_page + 1) * (win_last - win_first + 1);
+  if(window_cost <= page_cost) {
+    add_window_ssd1306(first_page, last_page, win_first, win_last);
+  } else {
+    for(uint8_t page = first_page; page <= last_page; ++page) {
+      if(get_dirty(page, &first_col, &last_col)) {
+        add_window_ssd1306(page, page, first_col, last_col);
+      }
     }
-    x++;
   }
-  new_content = 0x00;
 }
 
+/* Latch the frame, the value rows go out before the header */
+void OLED::latch_frame(void) {
+  refresh_pending = false;
+  update_time = millis();
+  latch_pages(VALUE_START_ROW, ROWS - 1);
+  latch_pages(HEADER_START_ROW, VALUE_START_ROW - 1);
+  clear_dirty();
+}
+
+/* Request the changes to be sent, the transfer is done by service() */
 void OLED::refresh(void) {
-  if(new_content > 0) {
-    update_ssd1306(addr, display_buf);
+  if(refresh_pending) {
+    // Folded into the frame that is already waiting
+    stats.skipped++;
+  }
+  refresh_pending = true;
+  service();
+}
+
+/* Send one bounded chunk of the frame in flight, returns true while busy */
+bool OLED::service(void) {
+  if(num_windows == 0) {
+    // Frame rate cap, later drawing keeps collecting in display_buf
+    if(!refresh_pending || millis() - update_time < interval) {
+      return false;
+    }
+    // Later drawing goes to display_buf while transfer_buf is sent
+    latch_frame();
+    if(num_windows == 0) {
+      return false;
+    }
+  }
+  send_chunk_ssd1306(addr, transfer_buf);
+
+  return num_windows != 0;
+}
+
+bool OLED::busy(void) const {
+  return num_windows != 0 || refresh_pending;
+}
+
+/* Send everything now, blocking and regardless of the frame rate cap */
+void OLED::flush(void) {
+  while(num_windows != 0) {
+    send_chunk_ssd1306(addr, transfer_buf);
+  }
+  latch_frame();
+  while(num_windows != 0) {
+    send_chunk_ssd1306(addr, transfer_buf);
   }
 }
 
 void OLED::set_unit(enum UNITS unit) {
-  print_unit(display_buf, unit);
-#ifdef SINGLE
-  new_content |= (0x01 << (0 + VALUE_START_ROW));
-#endif
-#ifdef DOUBLE
-  new_content |= (0x01 << (1 + VALUE_START_ROW));
-#endif
-#ifdef TRIPLE
-  new_content |= (0x01 << (2 + VALUE_START_ROW));
-#endif
-#ifdef QUADRO
-  new_content |= (0x01 << (3 + VALUE_START_ROW));
-#endif
+  this->unit = unit;
+  print_unit(display_buf[0], unit, value_size);
+}
+
+/* Switch the value font, the value rows are blanked until the next set_value */
+void OLED::set_value_size(FontSize size) {
+  if(size == value_size) {
+    return;
+  }
+  value_size = size;
+  memset(display_buf[VALUE_START_ROW], 0x00, (ROWS - VALUE_START_ROW) * COLUMNS);
+  forget_value();
+  for(uint8_t row = VALUE_START_ROW; row < ROWS; ++row) {
+    mark_dirty(row, 0, COLUMNS - 1);
+  }
+  print_unit(display_buf[0], unit, value_size);
 }
 
 void OLED::set_header(const char *buf, Alignment alignment) {
-  print_header(display_buf, buf, alignment);
-  new_content |= (0x01 << HEADER_START_ROW);
+  print_header(display_buf[0], buf, alignment);
 }
 
 void OLED::set_value(const char *buf) {
-  print_value(display_buf, buf);
-#ifdef SINGLE
-  new_content |= (0x01 << VALUE_START_ROW);
-#endif
-#ifdef DOUBLE
-  new_content |= (0x03 << VALUE_START_ROW);
-#endif
-#ifdef TRIPLE
-  new_content |= (0x07 << VALUE_START_ROW);
-#endif
-#ifdef QUADRO
-  new_content |= (0x0F << VALUE_START_ROW);
-#endif
-  // debug_data(display_buf);
+  print_value(display_buf[0], buf, value_size);
+  // debug_data(display_buf[0]);
 }
 
 void OLED::set_value(int32_t value, uint8_t decimals) {
-    char str[8] = "";
-    uint8_t negative = 0;
+  char str[8] = "";
 
-    if(value < 0) {
-        negative = 1;
-        value = -value;
-    }
+  if(format_value(str, value, decimals)) {
+    set_value(str);
+  }
+}
 
-    switch(decimals) {
-        case 0:
-            value = value%1000000;
-            if(negative) {
-                sprintf(str, "-%0ld", value);
-            } else {
-                sprintf(str, "%0ld", value);
-            }
-            set_value(str);
-            break;
-        case 1:
-            value = value%100000;
-            if(negative) {
-                sprintf(str, "-%0ld.%01ld", value/10, value%10);
-            } else {
-                sprintf(str, "%0ld.%01ld", value/10, value%10);
-            }
-            set_value(str);
-            break;
-        case 2:
-            value = value%100000;
-            if(negative) {
-                sprintf(str, "-%0ld.%02ld", value/100, value%100);
-            } else {
-                sprintf(str, "%0ld.%02ld", value/100, value%100);
-            }
-            set_value(str);
-            break;
-        case 3:
-            value = value%100000;
-            if(negative) {
-                sprintf(str, "-%0ld.%03ld", value/1000, value%1000);
-            } else {
-                sprintf(str, "%0ld.%03ld", value/1000, value%1000);
-            }
-            set_value(str);
-            break;
-        default:
-            break;
-    }
+/* Blank the whole display, for switching between layouts */
+void OLED::clear(void) {
+  memset(display_buf, 0x00, sizeof(display_buf));
+  forget_value();
+  mark_all_dirty();
+}
 
-    //cprintf("%s\n", str);
-}
\ No newline at end of file
+/* Render the widgets that changed since the last draw */
+void OLED::draw(Dashboard &dashboard) {
+  dashboard.render(display_buf[0]);
+}
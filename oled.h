@@ -1,6 +1,7 @@
 #pragma once
 
 #include "display.h"
+#include "widgets.h"
 
 #define OLED_CMD 0x00
 #define OLED_DATA 0x40
@@ -8,33 +9,81 @@
 #define COLUMNS   128
 #define ROWS      4
 #define ROWPIXELS 32
+// Bytes per I2C transaction including the control byte, match the Wire buffer
+#ifndef OLED_I2C_CHUNK
+#if defined(ARDUINO_ARCH_AVR)
+#define OLED_I2C_CHUNK  32
+#else
+#define OLED_I2C_CHUNK  128
+#endif
+#endif
+// Address byte, control byte and 0x21/0x22 window commands
+#define OLED_WINDOW_COST 8
+
+struct oled_window {
+  uint8_t first_page;
+  uint8_t last_page;
+  uint8_t first_col;
+  uint8_t last_col;
+};
+
+struct oled_stats {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t frames;
+  uint32_t skipped;
+};
+
 /*
  * Class OLED
  */
 class OLED {
 private:
-  uint32_t display_buf[COLUMNS*ROWS/4];
+  uint8_t display_buf[ROWS][COLUMNS];
+  uint8_t transfer_buf[ROWS][COLUMNS];
+  struct oled_window windows[ROWS];
+  uint8_t num_windows {0};
+  uint8_t window_index {0};
+  uint32_t window_sent {0};
+  bool window_started {false};
+  bool refresh_pending {false};
   uint8_t addr;
+  // Start of the last frame and the minimum time between frames, ms
   uint32_t update_time {0};
   uint32_t interval;
-  uint8_t new_content {0xFF};
+  struct oled_stats stats {};
+  FontSize value_size {FontSize::Triple};
+  enum UNITS unit {UNIT_none};
   void command_ssd1306(uint8_t addr, uint8_t cmd);
   void command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t conf);
   void command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t conf, uint8_t param);
   void command_ssd1306(uint8_t addr, uint8_t cmd, uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint8_t e, uint8_t f);
+  void command_ssd1306(uint8_t addr, const uint8_t *cmds, uint8_t len);
   void init_ssd1306(uint8_t addr);
   void init_ssd1306_32(uint8_t addr);
   void init_ssd1306_64_toimii(uint8_t addr);
   void write_data_ssd1306(uint8_t addr, uint8_t* data, uint32_t len);
-  void update_ssd1306(uint8_t addr, uint32_t* data);
+  void add_window_ssd1306(uint8_t first_page, uint8_t last_page, uint8_t first_col, uint8_t last_col);
+  void latch_pages(uint8_t first, uint8_t last);
+  void latch_frame(void);
+  void send_chunk_ssd1306(uint8_t addr, uint8_t (*data)[COLUMNS]);
+  void count_transaction(uint32_t len);
 
 public:
   OLED(uint8_t addr, uint32_t interval);
   void start(void);
   void refresh(void);
+  bool service(void);
+  bool busy(void) const;
+  void flush(void);
   void set_value(const char *buf);
   void set_value(int32_t value, uint8_t decimals);
   void set_header(const char *buf, Alignment alignment = Alignment::Left);
   void set_unit(enum UNITS unit);
+  void set_value_size(FontSize size);
+  void clear(void);
+  void draw(Dashboard &dashboard);
+  const struct oled_stats &get_stats(void) const;
+  void reset_stats(void);
 
 };
\ No newline at end of file
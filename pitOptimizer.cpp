@@ -0,0 +1,122 @@
+#include <string.h>
+#include "pitOptimizer.h"
+#include "fuelCalculator.h"
+
+/*
+ * Cost of a stint is the time carrying its fuel: at the start of each lap
+ * the car holds the fuel for the laps still to go. For refuelled stints it
+ * adds the pit lane and the refuelling. Total fuel is fixed, so the only
+ * choices are the stop count and the laps on the start fuel. Stint weight
+ * is convex in its laps, so the refuelled laps split as evenly as possible
+ * and the cost is convex in the first stint, which bounds both loops.
+ */
+
+/* Fuel weight cost of a stint of laps, ms */
+static uint32_t stint_weight_ms(uint8_t laps, uint8_t fuel_consumption) {
+    uint32_t tenth_laps = static_cast<uint32_t>(fuel_consumption) * laps * (laps + 1U) / 2U;
+
+    return tenth_laps * cWEIGHT_MS_PER_TENTH_LAP_X4 / 4U;
+}
+
+/* Even split of laps over stints, the first laps % stints of them get one more lap */
+static uint32_t split_weight_ms(uint8_t laps, uint8_t stints, uint8_t fuel_consumption) {
+    uint8_t base;
+    uint8_t longer;
+
+    if (stints == 0U) {
+        return 0U;
+    }
+    base = laps / stints;
+    longer = laps % stints;
+    return longer * stint_weight_ms(base + 1U, fuel_consumption) +
+           (stints - longer) * stint_weight_ms(base, fuel_consumption);
+}
+
+static uint32_t plan_cost_ms(uint8_t laps, uint8_t first, uint8_t stops, uint8_t fuel_consumption, uint32_t pit_ms) {
+    uint8_t refuelled = laps - first;
+
+    return stops * pit_ms +
+           static_cast<uint32_t>(refuelled) * fuel_consumption * cREFUEL_MS_PER_TENTH +
+           stint_weight_ms(first, fuel_consumption) +
+           split_weight_ms(refuelled, stops, fuel_consumption);
+}
+
+static void fill_plan(pit_plan &plan, uint8_t first, uint8_t stops, uint8_t fuel_consumption) {
+    uint8_t refuelled = plan.laps - first;
+
+    plan.stops = stops;
+    memset(plan.stint_laps, 0, sizeof(plan.stint_laps));
+    memset(plan.fuel, 0, sizeof(plan.fuel));
+    plan.stint_laps[0] = first;
+    for (uint8_t i = 1; i <= stops; ++i) {
+        plan.stint_laps[i] = refuelled / stops + (i <= refuelled % stops);
+    }
+    for (uint8_t i = 0; i <= stops; ++i) {
+        plan.fuel[i] = static_cast<uint16_t>(plan.stint_laps[i]) * fuel_consumption;
+    }
+}
+
+bool plan_pit_stops(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint8_t fuel_consumption,
+                    uint8_t tank_capacity, uint8_t pit_loss, pit_plan &plan) {
+    int32_t laps = calculate_whole_laps(warmup, race_length, laptime);
+    uint32_t pit_ms = pit_loss * 1000UL;
+    uint32_t best = UINT32_MAX;
+    uint8_t best_first = 0;
+    uint8_t best_stops = 0;
+    uint8_t tank_laps;
+
+    memset(&plan, 0, sizeof(plan));
+    plan.complete = true;
+    if (laps > UINT8_MAX) {
+        return false;
+    }
+    plan.laps = static_cast<uint8_t>(laps);
+    if (fuel_consumption == 0U || plan.laps == 0U) {
+        fill_plan(plan, plan.laps, 0, fuel_consumption);
+        return true;
+    }
+    tank_laps = tank_capacity * 10U / fuel_consumption > UINT8_MAX ? UINT8_MAX : tank_capacity * 10U / fuel_consumption;
+
+    for (uint8_t stops = 0; stops <= PIT_MAX_STOPS; ++stops) {
+        // Every stop costs at least the pit lane
+        if (stops * pit_ms >= best) {
+            break;
+        }
+        // Each refuelled stint needs a lap and at most a tank, so does the first
+        if (stops >= plan.laps) {
+            break;
+        }
+        uint8_t most = plan.laps - stops < tank_laps ? plan.laps - stops : tank_laps;
+        uint8_t least = plan.laps > stops * tank_laps ? plan.laps - stops * tank_laps : 1U;
+        uint32_t previous = UINT32_MAX;
+
+        if (stops == 0U) {
+            least = plan.laps;
+        }
+        // Most start fuel first, the cost falls to its minimum and then rises
+        for (int16_t first = most; first >= least; --first) {
+            if (plan.steps == PIT_SEARCH_STEPS) {
+                plan.complete = false;
+                break;
+            }
+            plan.steps++;
+            uint32_t cost = plan_cost_ms(plan.laps, first, stops, fuel_consumption, pit_ms);
+            if (cost > previous) {
+                break;
+            }
+            previous = cost;
+            if (cost < best) {
+                best = cost;
+                best_first = first;
+                best_stops = stops;
+            }
+        }
+    }
+
+    if (best == UINT32_MAX) {
+        return false;
+    }
+    fill_plan(plan, best_first, best_stops, fuel_consumption);
+    plan.cost_ms = best;
+    return true;
+}
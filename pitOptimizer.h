@@ -0,0 +1,32 @@
+#pragma once
+
+#include "stdint.h"
+
+#define PIT_MAX_STOPS           4
+/* Cost evaluations allowed per plan, the search stops early when it runs out */
+#define PIT_SEARCH_STEPS        512
+
+static constexpr uint8_t cMIN_TANK_CAPACITY = 20U;
+static constexpr uint8_t cMAX_TANK_CAPACITY = 140U;
+static constexpr uint8_t cMIN_PIT_LOSS = 10U;
+static constexpr uint8_t cMAX_PIT_LOSS = 90U;
+/* Refuelling at 2 l/s, and 0.03 s per kg per lap with fuel at 0.75 kg/l */
+static constexpr uint32_t cREFUEL_MS_PER_TENTH = 50U;
+static constexpr uint32_t cWEIGHT_MS_PER_TENTH_LAP_X4 = 9U;
+
+struct pit_plan {
+    uint8_t laps;                               // laps to the flag
+    uint8_t stops;
+    uint8_t stint_laps[PIT_MAX_STOPS + 1];      // first stint runs on the start fuel
+    uint16_t fuel[PIT_MAX_STOPS + 1];           // 0.1 l, start fuel then each refuel
+    uint32_t cost_ms;                           // pit lane, refuelling and fuel weight
+    uint16_t steps;
+    bool complete;                              // false if PIT_SEARCH_STEPS ran out
+};
+
+/*
+ * Fastest pit strategy for a race from the calculator parameters. Returns
+ * false when even PIT_MAX_STOPS stops can't cover the race.
+ */
+bool plan_pit_stops(uint8_t warmup, uint8_t race_length, uint8_t laptime, uint8_t fuel_consumption,
+                    uint8_t tank_capacity, uint8_t pit_loss, pit_plan &plan);
@@ -0,0 +1,40 @@
+#include <Arduino.h>
+#include "power.h"
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+
+static uint32_t sleep_us;
+
+void power_idle(void) {
+    uint32_t start = micros();
+
+#if defined(ARDUINO_ARCH_SAMD)
+    // Idle rather than standby so the SysTick and SERCOM clocks keep running
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    __DSB();
+    __WFI();
+    sleep_us += micros() - start;
+    interrupts();
+#elif defined(__AVR__)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    // sei takes effect after the next instruction, sleep is entered first
+    sei();
+    sleep_cpu();
+    sleep_disable();
+    sleep_us += micros() - start;
+#elif defined(HOST_SIM)
+    sim_idle();
+    sleep_us += micros() - start;
+    interrupts();
+#else
+    interrupts();
+    delay(1);
+    sleep_us += micros() - start;
+#endif
+}
+
+uint32_t power_sleep_us(void) {
+    return sleep_us;
+}
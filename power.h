@@ -0,0 +1,12 @@
+#pragma once
+
+#include "stdint.h"
+
+/*
+ * Idle sleep until the next interrupt. Call with interrupts disabled once
+ * there is no work left, returns with them enabled, so an interrupt that
+ * arrives after the check still wakes the core.
+ */
+void power_idle(void);
+/* Total time spent in power_idle() */
+uint32_t power_sleep_us(void);
@@ -0,0 +1,277 @@
+#include <Arduino.h>
+#include <ctype.h>
+#include <string.h>
+#include "profiles.h"
+#include "fuelMeter.h"
+
+static uint32_t area_offset(uint8_t area) {
+    return FLASH_LOG_BYTES + static_cast<uint32_t>(area) * FLASH_PROFILE_BYTES;
+}
+
+static uint16_t blob_len(const uint8_t *header) {
+    return PROFILE_BLOB_BYTES(header[2], header[3], header[4]);
+}
+
+static bool check_header(const uint8_t *header) {
+    return header[0] == cPROFILE_MAGIC && header[1] == cPROFILE_VERSION &&
+           header[2] > 0U && header[2] <= PROFILE_MAX_CARS &&
+           header[3] > 0U && header[3] <= PROFILE_MAX_TRACKS &&
+           header[4] > 0U && header[4] <= PROFILE_MAX;
+}
+
+/* Same ranges as the encoder gives the calculator inputs */
+static bool check_entry(const uint8_t *entry, const uint8_t *header) {
+    return entry[0] < header[2] && entry[1] < header[3] &&
+           entry[2] >= cMIN_LAPTIME && entry[2] <= cMAX_LAPTIME &&
+           entry[3] >= cMIN_FUEL_CUNSUMPTION && entry[3] <= cMAX_FUEL_CUNSUMPTION &&
+           entry[4] >= cMIN_RACE_REMAINING && entry[4] <= cMAX_RACE_REMAINING &&
+           entry[5] <= 1U;
+}
+
+static void put_name(uint8_t *dst, const char *name) {
+    size_t i = 0;
+
+    for (; i < PROFILE_NAME_LEN && name[i] != '\0'; ++i) {
+        dst[i] = static_cast<uint8_t>(toupper(name[i]));
+    }
+    for (; i < PROFILE_NAME_LEN; ++i) {
+        dst[i] = ' ';
+    }
+}
+
+size_t encode_profile_blob(const char *const *cars, uint8_t car_count, const char *const *tracks, uint8_t track_count,
+                           const profile *profiles, uint8_t profile_count, uint8_t *blob) {
+    size_t len = PROFILE_HEADER_BYTES;
+
+    if (car_count > PROFILE_MAX_CARS || track_count > PROFILE_MAX_TRACKS || profile_count > PROFILE_MAX) {
+        return 0;
+    }
+    blob[0] = cPROFILE_MAGIC;
+    blob[1] = cPROFILE_VERSION;
+    blob[2] = car_count;
+    blob[3] = track_count;
+    blob[4] = profile_count;
+    blob[5] = 0x00;
+    for (uint8_t i = 0; i < car_count; ++i, len += PROFILE_NAME_LEN) {
+        put_name(&blob[len], cars[i]);
+    }
+    for (uint8_t i = 0; i < track_count; ++i, len += PROFILE_NAME_LEN) {
+        put_name(&blob[len], tracks[i]);
+    }
+    for (uint8_t i = 0; i < profile_count; ++i, len += PROFILE_ENTRY_BYTES) {
+        blob[len] = profiles[i].car;
+        blob[len + 1] = profiles[i].track;
+        blob[len + 2] = profiles[i].laptime;
+        blob[len + 3] = profiles[i].fuel_consumption;
+        blob[len + 4] = profiles[i].race_length;
+        blob[len + 5] = profiles[i].warmup;
+    }
+    blob[len] = crc8(blob, len);
+    return len + 1;
+}
+
+/* The first write unit of an upload is still in RAM */
+void ProfileTable::read_area(uint8_t area, uint16_t offset, uint8_t *data, uint8_t len) const {
+    for (; len > 0 && m_receiving && area == m_target && offset < FLASH_WRITE_BYTES; --len) {
+        *data++ = m_first[offset++];
+    }
+    if (len > 0) {
+        flash_read(area_offset(area) + offset, data, len);
+    }
+}
+
+/* Header, every entry and the CRC, read back from flash */
+bool ProfileTable::check_blob(uint8_t area, uint8_t *header) const {
+    uint8_t data[TELEMETRY_CHUNK_BYTES];
+    uint8_t crc;
+    uint16_t len;
+    uint16_t entries;
+
+    read_area(area, cPROFILE_BLOB_OFFSET, header, PROFILE_HEADER_BYTES);
+    if (!check_header(header)) {
+        return false;
+    }
+    len = blob_len(header) - 1;
+    crc = crc8(header, PROFILE_HEADER_BYTES);
+    for (uint16_t pos = PROFILE_HEADER_BYTES; pos < len; pos += sizeof(data)) {
+        uint8_t part = (len - pos < static_cast<uint16_t>(sizeof(data))) ? static_cast<uint8_t>(len - pos) : sizeof(data);
+        read_area(area, cPROFILE_BLOB_OFFSET + pos, data, part);
+        crc = crc8(data, part, crc);
+    }
+    read_area(area, cPROFILE_BLOB_OFFSET + len, data, 1);
+    if (data[0] != crc) {
+        return false;
+    }
+    entries = PROFILE_HEADER_BYTES + (header[2] + header[3]) * PROFILE_NAME_LEN;
+    for (uint8_t i = 0; i < header[4]; ++i) {
+        read_area(area, cPROFILE_BLOB_OFFSET + entries + i * PROFILE_ENTRY_BYTES, data, PROFILE_ENTRY_BYTES);
+        if (!check_entry(data, header)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The valid table with the highest generation, false if there is none */
+bool ProfileTable::load(void) {
+    uint8_t header[PROFILE_HEADER_BYTES];
+    uint8_t raw[cPROFILE_BLOB_OFFSET];
+    bool found = false;
+
+    m_count = 0;
+    if (!flash_available()) {
+        return false;
+    }
+    for (uint8_t area = 0; area < 2; ++area) {
+        flash_read(area_offset(area), raw, sizeof(raw));
+        uint32_t generation = static_cast<uint32_t>(raw[0]) | static_cast<uint32_t>(raw[1]) << 8 |
+                              static_cast<uint32_t>(raw[2]) << 16 | static_cast<uint32_t>(raw[3]) << 24;
+        if (generation == 0xFFFFFFFFUL || (found && generation <= m_stats.generation) || !check_blob(area, header)) {
+            continue;
+        }
+        found = true;
+        m_area = area;
+        m_cars = header[2];
+        m_tracks = header[3];
+        m_count = header[4];
+        m_stats.generation = generation;
+    }
+    return found;
+}
+
+uint8_t ProfileTable::count(void) const {
+    return m_count;
+}
+
+bool ProfileTable::get(uint8_t index, profile &entry) const {
+    uint8_t raw[PROFILE_ENTRY_BYTES];
+
+    if (index >= m_count) {
+        return false;
+    }
+    read_area(m_area, cPROFILE_BLOB_OFFSET + PROFILE_HEADER_BYTES + (m_cars + m_tracks) * PROFILE_NAME_LEN +
+              index * PROFILE_ENTRY_BYTES, raw, sizeof(raw));
+    entry.car = raw[0];
+    entry.track = raw[1];
+    entry.laptime = raw[2];
+    entry.fuel_consumption = raw[3];
+    entry.race_length = raw[4];
+    entry.warmup = raw[5];
+    return true;
+}
+
+/* Car and track names, text needs PROFILE_TEXT_LEN + 1 bytes */
+void ProfileTable::get_text(uint8_t index, char *text) const {
+    profile entry;
+    uint8_t len;
+
+    text[0] = '\0';
+    if (!get(index, entry)) {
+        return;
+    }
+    read_area(m_area, cPROFILE_BLOB_OFFSET + PROFILE_HEADER_BYTES + entry.car * PROFILE_NAME_LEN,
+              reinterpret_cast<uint8_t *>(text), PROFILE_NAME_LEN);
+    for (len = PROFILE_NAME_LEN; len > 0 && text[len - 1] == ' '; --len) {
+    }
+    text[len++] = ' ';
+    read_area(m_area, cPROFILE_BLOB_OFFSET + PROFILE_HEADER_BYTES + (m_cars + entry.track) * PROFILE_NAME_LEN,
+              reinterpret_cast<uint8_t *>(&text[len]), PROFILE_NAME_LEN);
+    for (len += PROFILE_NAME_LEN; len > 0 && text[len - 1] == ' '; --len) {
+    }
+    text[len] = '\0';
+}
+
+ProfileUpload ProfileTable::fail(void) {
+    m_receiving = false;
+    m_stats.failures++;
+    return ProfileUpload::Failed;
+}
+
+/*
+ * Chunks must come in order, offset 0 starts over. The area not in use is
+ * erased first, a table too big for it is refused by its header.
+ */
+ProfileUpload ProfileTable::receive(const blob_chunk &chunk) {
+    if (chunk.offset == 0U) {
+        m_target = m_count > 0U ? 1U - m_area : 0U;
+        m_receiving = false;
+        for (uint32_t block = 0; block < FLASH_PROFILE_BYTES; block += FLASH_BLOCK_BYTES) {
+            if (!flash_erase(area_offset(m_target) + block)) {
+                return fail();
+            }
+        }
+        m_receiving = true;
+        m_received = 0;
+        m_blob_len = 0;
+        memset(m_first, 0xFF, sizeof(m_first));
+        memset(m_unit, 0xFF, sizeof(m_unit));
+    }
+    if (!m_receiving || chunk.offset != m_received) {
+        return fail();
+    }
+    for (uint8_t i = 0; i < chunk.len; ++i) {
+        if (!write_byte(chunk.data[i])) {
+            return fail();
+        }
+    }
+    if (m_blob_len > 0U && m_received == m_blob_len) {
+        return finish_upload() ? ProfileUpload::Done : fail();
+    }
+    return ProfileUpload::Receiving;
+}
+
+/* Stage a byte, full write units after the first go straight to flash */
+bool ProfileTable::write_byte(uint8_t byte) {
+    uint16_t pos = cPROFILE_BLOB_OFFSET + m_received;
+
+    if (m_blob_len > 0U && m_received >= m_blob_len) {
+        return false;
+    }
+    if (pos < FLASH_WRITE_BYTES) {
+        m_first[pos] = byte;
+    } else {
+        m_unit[pos % FLASH_WRITE_BYTES] = byte;
+        if ((pos + 1U) % FLASH_WRITE_BYTES == 0U) {
+            if (!flash_write(area_offset(m_target) + pos + 1U - FLASH_WRITE_BYTES, m_unit, FLASH_WRITE_BYTES)) {
+                return false;
+            }
+            memset(m_unit, 0xFF, sizeof(m_unit));
+        }
+    }
+    if (++m_received == PROFILE_HEADER_BYTES) {
+        if (!check_header(&m_first[cPROFILE_BLOB_OFFSET])) {
+            return false;
+        }
+        m_blob_len = blob_len(&m_first[cPROFILE_BLOB_OFFSET]);
+    }
+    return true;
+}
+
+/* Verify what went to flash, then make it current with the first unit */
+bool ProfileTable::finish_upload(void) {
+    uint8_t header[PROFILE_HEADER_BYTES];
+    uint16_t end = cPROFILE_BLOB_OFFSET + m_received;
+    uint32_t generation = m_count > 0U ? m_stats.generation + 1U : 1U;
+
+    if (end > FLASH_WRITE_BYTES && end % FLASH_WRITE_BYTES != 0U &&
+        !flash_write(area_offset(m_target) + end - end % FLASH_WRITE_BYTES, m_unit, FLASH_WRITE_BYTES)) {
+        return false;
+    }
+    if (!check_blob(m_target, header)) {
+        return false;
+    }
+    m_first[0] = static_cast<uint8_t>(generation);
+    m_first[1] = static_cast<uint8_t>(generation >> 8);
+    m_first[2] = static_cast<uint8_t>(generation >> 16);
+    m_first[3] = static_cast<uint8_t>(generation >> 24);
+    m_receiving = false;
+    if (!flash_write(area_offset(m_target), m_first, FLASH_WRITE_BYTES) || !load() || m_stats.generation != generation) {
+        return false;
+    }
+    m_stats.uploads++;
+    return true;
+}
+
+const profile_stats &ProfileTable::get_stats(void) const {
+    return m_stats;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "stdint.h"
+#include "flash.h"
+#include "telemetryProtocol.h"
+
+/*
+ * Profile table blob, uploaded as is over telemetry chunks and stored in
+ * flash. A header of magic, version and the car, track and profile
+ * counts, then the car names, the track names, the profiles and a CRC-8
+ * over everything before it. Names are space padded upper case.
+ */
+#define PROFILE_NAME_LEN        8
+#define PROFILE_MAX_CARS        8
+#define PROFILE_MAX_TRACKS      8
+#define PROFILE_MAX             32
+#define PROFILE_HEADER_BYTES    6
+#define PROFILE_ENTRY_BYTES     6
+#define PROFILE_BLOB_BYTES(cars, tracks, profiles) \
+    (PROFILE_HEADER_BYTES + ((cars) + (tracks)) * PROFILE_NAME_LEN + (profiles) * PROFILE_ENTRY_BYTES + 1)
+/* Car and track with a space between them */
+#define PROFILE_TEXT_LEN        (2 * PROFILE_NAME_LEN + 1)
+
+static constexpr uint8_t cPROFILE_MAGIC = 0xC7U;
+static constexpr uint8_t cPROFILE_VERSION = 1U;
+/* An area starts with the generation of its table, the blob follows */
+static constexpr uint32_t cPROFILE_BLOB_OFFSET = 4U;
+
+static_assert(cPROFILE_BLOB_OFFSET + PROFILE_BLOB_BYTES(PROFILE_MAX_CARS, PROFILE_MAX_TRACKS, PROFILE_MAX) <= FLASH_PROFILE_BYTES,
+              "The largest table must fit in a profile area");
+static_assert(FLASH_PROFILE_BYTES % FLASH_BLOCK_BYTES == 0, "Profile areas are erased in whole blocks");
+static_assert(cPROFILE_BLOB_OFFSET + PROFILE_HEADER_BYTES <= FLASH_WRITE_BYTES, "The blob header must be in the first write unit");
+
+struct profile {
+    uint8_t car;
+    uint8_t track;
+    uint8_t laptime;
+    uint8_t fuel_consumption;
+    uint8_t race_length;
+    uint8_t warmup;
+};
+
+enum class ProfileUpload {
+    Receiving,
+    Done,
+    Failed
+};
+
+struct profile_stats {
+    uint16_t uploads;
+    uint16_t failures;
+    uint32_t generation;
+};
+
+/* Blob for an upload, 0 if a count is over its limit */
+size_t encode_profile_blob(const char *const *cars, uint8_t car_count, const char *const *tracks, uint8_t track_count,
+                           const profile *profiles, uint8_t profile_count, uint8_t *blob);
+
+/*
+ * Profile tables in two flash areas. An upload goes to the area not in
+ * use and its generation is written last, after the CRC checked out, so
+ * a failed upload leaves the current table as it was. Entries are read
+ * from flash when asked for, only the counts are kept in RAM.
+ */
+class ProfileTable {
+public:
+    bool load(void);
+    uint8_t count(void) const;
+    bool get(uint8_t index, profile &entry) const;
+    void get_text(uint8_t index, char *text) const;
+    ProfileUpload receive(const blob_chunk &chunk);
+    const profile_stats &get_stats(void) const;
+
+private:
+    void read_area(uint8_t area, uint16_t offset, uint8_t *data, uint8_t len) const;
+    bool check_blob(uint8_t area, uint8_t *header) const;
+    bool write_byte(uint8_t byte);
+    bool finish_upload(void);
+    ProfileUpload fail(void);
+
+    uint8_t m_area {0};
+    uint8_t m_cars {0};
+    uint8_t m_tracks {0};
+    uint8_t m_count {0};
+    // Upload in progress, the first write unit holds the generation and is written last
+    bool m_receiving {false};
+    uint8_t m_target {0};
+    uint16_t m_received {0};
+    uint16_t m_blob_len {0};
+    uint8_t m_crc {0};
+    uint8_t m_first[FLASH_WRITE_BYTES];
+    uint8_t m_unit[FLASH_WRITE_BYTES];
+    profile_stats m_stats {};
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "stdint.h"
+
+/*
+ * Lock-free single producer, single consumer ring buffer. The producer may
+ * run in interrupt context; only push() writes the head index and only
+ * pop() writes the tail index.
+ */
+template <typename T, uint8_t SIZE>
+class RingBuffer {
+    static_assert(SIZE > 0 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two up to 128");
+public:
+    bool push(const T &item) {
+        uint8_t head = m_head;
+
+        if (static_cast<uint8_t>(head - m_tail) == SIZE) {
+            m_dropped++;
+            return false;
+        }
+        m_items[head & (SIZE - 1)] = item;
+        barrier();
+        m_head = head + 1;
+        return true;
+    }
+
+    bool pop(T &item) {
+        uint8_t tail = m_tail;
+
+        if (tail == m_head) {
+            return false;
+        }
+        barrier();
+        item = m_items[tail & (SIZE - 1)];
+        barrier();
+        m_tail = tail + 1;
+        return true;
+    }
+
+    /* Slot to fill in place, nullptr when full, made visible by publish() */
+    T *claim(void) {
+        uint8_t head = m_head;
+
+        if (static_cast<uint8_t>(head - m_tail) == SIZE) {
+            m_dropped++;
+            return nullptr;
+        }
+        return &m_items[head & (SIZE - 1)];
+    }
+
+    void publish(void) {
+        barrier();
+        m_head = m_head + 1;
+    }
+
+    /* Oldest item read in place, nullptr when empty, freed by release() */
+    T *front(void) {
+        uint8_t tail = m_tail;
+
+        if (tail == m_head) {
+            return nullptr;
+        }
+        barrier();
+        return &m_items[tail & (SIZE - 1)];
+    }
+
+    void release(void) {
+        barrier();
+        m_tail = m_tail + 1;
+    }
+
+    bool empty(void) const {
+        return m_head == m_tail;
+    }
+
+    uint8_t count(void) const {
+        return static_cast<uint8_t>(m_head - m_tail);
+    }
+
+    uint16_t dropped(void) const {
+        return m_dropped;
+    }
+
+private:
+    /* Keep the compiler from moving item accesses across index updates */
+    static inline void barrier(void) {
+        __asm__ __volatile__("" ::: "memory");
+    }
+
+    T m_items[SIZE];
+    volatile uint8_t m_head {0};
+    volatile uint8_t m_tail {0};
+    volatile uint16_t m_dropped {0};
+};
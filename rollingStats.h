@@ -0,0 +1,144 @@
+#pragma once
+
+#include "stdint.h"
+
+/* Integer square root, rounded down */
+static inline uint16_t isqrt32(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint16_t>(root);
+}
+
+/*
+ * Mean, variance, min and max of the last SIZE samples. Every add() is
+ * O(1): the sums drop the sample that falls out of the window, and min and
+ * max come from monotonic queues of sample numbers. Sample numbers are
+ * uint8_t and wrap, which is fine while SIZE is at most 128.
+ */
+template <uint8_t SIZE>
+class RollingStats {
+    static_assert(SIZE > 0 && SIZE <= 128 && (SIZE & (SIZE - 1)) == 0, "SIZE must be a power of two up to 128");
+public:
+    void add(uint16_t sample) {
+        uint8_t seq = m_seq++;
+
+        if (m_count == SIZE) {
+            uint16_t old = m_samples[seq & (SIZE - 1)];
+            m_sum -= old;
+            m_sum_sq -= static_cast<uint32_t>(old) * old;
+        } else {
+            m_count++;
+        }
+        m_samples[seq & (SIZE - 1)] = sample;
+        m_sum += sample;
+        m_sum_sq += static_cast<uint32_t>(sample) * sample;
+        m_min.add(m_samples, seq, sample);
+        m_max.add(m_samples, seq, sample);
+    }
+
+    void reset(void) {
+        m_seq = 0;
+        m_count = 0;
+        m_sum = 0;
+        m_sum_sq = 0;
+        m_min.reset();
+        m_max.reset();
+    }
+
+    uint8_t count(void) const {
+        return m_count;
+    }
+
+    uint16_t last(void) const {
+        return m_count ? m_samples[static_cast<uint8_t>(m_seq - 1) & (SIZE - 1)] : 0;
+    }
+
+    /* Rounded to the nearest unit */
+    uint16_t mean(void) const {
+        return m_count ? static_cast<uint16_t>((m_sum + m_count / 2) / m_count) : 0;
+    }
+
+    /* Sample variance in squared units, 0 until there are two samples */
+    uint32_t variance(void) const {
+        if (m_count < 2) {
+            return 0;
+        }
+        uint64_t spread = static_cast<uint64_t>(m_count) * m_sum_sq - static_cast<uint64_t>(m_sum) * m_sum;
+        return static_cast<uint32_t>(spread / (static_cast<uint32_t>(m_count) * (m_count - 1)));
+    }
+
+    uint16_t stddev(void) const {
+        return isqrt32(variance());
+    }
+
+    uint16_t min(void) const {
+        return m_count ? m_min.front(m_samples) : 0;
+    }
+
+    uint16_t max(void) const {
+        return m_count ? m_max.front(m_samples) : 0;
+    }
+
+private:
+    /* Sample numbers in window order with monotonic values, the front is the extreme */
+    template <bool MAX>
+    class Extreme {
+    public:
+        void add(const uint16_t *samples, uint8_t seq, uint16_t sample) {
+            // The window moves by one, at most the front falls out of it
+            if (m_len != 0 && static_cast<uint8_t>(seq - m_seqs[m_head]) >= SIZE) {
+                m_head = (m_head + 1) & (SIZE - 1);
+                m_len--;
+            }
+            // Samples beaten by the new one can never be the extreme again
+            while (m_len != 0 && !beats(samples[back() & (SIZE - 1)], sample)) {
+                m_len--;
+            }
+            m_seqs[(m_head + m_len) & (SIZE - 1)] = seq;
+            m_len++;
+        }
+
+        void reset(void) {
+            m_head = 0;
+            m_len = 0;
+        }
+
+        uint16_t front(const uint16_t *samples) const {
+            return samples[m_seqs[m_head] & (SIZE - 1)];
+        }
+
+    private:
+        static bool beats(uint16_t kept, uint16_t sample) {
+            return MAX ? kept > sample : kept < sample;
+        }
+
+        uint8_t back(void) const {
+            return m_seqs[(m_head + m_len - 1) & (SIZE - 1)];
+        }
+
+        uint8_t m_seqs[SIZE];
+        uint8_t m_head {0};
+        uint8_t m_len {0};
+    };
+
+    uint16_t m_samples[SIZE];
+    uint8_t m_seq {0};
+    uint8_t m_count {0};
+    uint32_t m_sum {0};
+    uint64_t m_sum_sq {0};
+    Extreme<false> m_min;
+    Extreme<true> m_max;
+};
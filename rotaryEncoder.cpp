@@ -27,20 +27,94 @@ RotaryEncoder::RotaryEncoder(uint8_t outputAPin, uint8_t outputBPin, RotaryMode
     m_input_last_state = 0;
     m_cw_button = 0;
     m_ccw_button = 0;
+    m_use_interrupt = false;
+    m_last_changed_time = 0;
 }
 
-void RotaryEncoder::init() {
+void RotaryEncoder::init(bool use_interrupt) {
     pinMode(m_dat_pin, INPUT_PULLUP);
     pinMode(m_clk_pin, INPUT_PULLUP);
+    m_dat_port = portInputRegister(digitalPinToPort(m_dat_pin));
+    m_clk_port = portInputRegister(digitalPinToPort(m_clk_pin));
+    m_dat_mask = digitalPinToBitMask(m_dat_pin);
+    m_clk_mask = digitalPinToBitMask(m_clk_pin);
+    m_use_interrupt = use_interrupt;
+}
+
+/* Read both pins straight from the port input registers */
+uint8_t RotaryEncoder::sample() {
+    return ((*m_dat_port & m_dat_mask) ? 0x02 : 0x00) | ((*m_clk_port & m_clk_mask) ? 0x01 : 0x00);
+}
+
+/* Pin change interrupt handler, queues completed steps */
+void RotaryEncoder::isr() {
+    encoder_event event;
+
+    uint32_t last_time = m_last_changed_time;
+
+    event.direction = step(sample());
+    if (event.direction != DIR_NONE) {
+        event.time = m_last_changed_time;
+        event.interval = m_last_changed_time - last_time;
+        m_events.push(event);
+    }
+}
+
+/* Get the next step, polls the pins unless interrupts are used */
+bool RotaryEncoder::read_event(encoder_event &event) {
+    uint32_t last_time = m_last_changed_time;
+
+    if (m_use_interrupt) {
+        return m_events.pop(event);
+    }
+
+    event.direction = step(sample());
+    event.time = m_last_changed_time;
+    event.interval = m_last_changed_time - last_time;
+    return event.direction != DIR_NONE;
+}
+
+/* Sum of all pending steps, CW positive, fast spins accelerated */
+int8_t RotaryEncoder::read_delta() {
+    encoder_event event;
+    int16_t delta = 0;
+    int8_t gain;
+
+    while (read_event(event)) {
+        if (event.interval < ACCEL_FAST_MS) {
+            gain = ACCEL_FAST_GAIN;
+        } else if (event.interval < ACCEL_MEDIUM_MS) {
+            gain = ACCEL_MEDIUM_GAIN;
+        } else {
+            gain = 1;
+        }
+        delta += (event.direction == DIR_CW) ? gain : -gain;
+    }
+
+    if (delta > INT8_MAX) {
+        delta = INT8_MAX;
+    } else if (delta < -INT8_MAX) {
+        delta = -INT8_MAX;
+    }
+    return static_cast<int8_t>(delta);
 }
 
 uint8_t RotaryEncoder::read() {
+    encoder_event event;
+
+    if (read_event(event)) {
+        return event.direction;
+    }
+    return DIR_NONE;
+}
+
+uint8_t RotaryEncoder::step(uint8_t pins) {
     uint8_t direction;
 
     if (m_mode == RotaryMode::HALF_STEP) {
-        m_input_last_state = halfStepsTable[m_input_last_state & STEP_MASK][(digitalRead(m_dat_pin) << 1) | digitalRead(m_clk_pin)];
+        m_input_last_state = halfStepsTable[m_input_last_state & STEP_MASK][pins];
     } else {
-        m_input_last_state = fullStepsTable[m_input_last_state & STEP_MASK][(digitalRead(m_dat_pin) << 1) | digitalRead(m_clk_pin)];
+        m_input_last_state = fullStepsTable[m_input_last_state & STEP_MASK][pins];
     }
 
     direction = (m_input_last_state & DIR_MASK);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "stdint.h"
+#include "ringBuffer.h"
 
 #define DIR_MASK        0x30
 #define STEP_MASK       0x0F
@@ -26,6 +27,26 @@ static constexpr uint8_t DIR_CCW    = 0x20;
 #define HS_R_CW_BEGIN_M  0x4
 #define HS_R_CCW_BEGIN_M 0x5
 
+#define ENCODER_EVENTS  32
+
+/* Acceleration, steps closer together than these are multiplied */
+static constexpr uint32_t ACCEL_FAST_MS     = 25U;
+static constexpr uint32_t ACCEL_MEDIUM_MS   = 60U;
+static constexpr int8_t ACCEL_FAST_GAIN     = 5;
+static constexpr int8_t ACCEL_MEDIUM_GAIN   = 2;
+
+#if defined(ARDUINO_ARCH_AVR)
+typedef volatile uint8_t port_reg_t;
+#else
+typedef volatile uint32_t port_reg_t;
+#endif
+
+struct encoder_event {
+    uint8_t direction;
+    uint32_t time;
+    uint32_t interval;
+};
+
 enum class RotaryMode {
     HALF_STEP = 0,
     FULL_STEP = 1
@@ -34,8 +55,11 @@ enum class RotaryMode {
 class RotaryEncoder {
 public:
     RotaryEncoder(uint8_t outputAPin, uint8_t outputBPin, RotaryMode mode);
-    void init(void);
+    void init(bool use_interrupt = false);
     uint8_t read(void);
+    bool read_event(encoder_event &event);
+    int8_t read_delta(void);
+    void isr(void);
     void set_joystick_id(uint8_t id);
 private:
     uint8_t m_dat_pin;
@@ -45,6 +69,15 @@ private:
     int m_counter;
     uint8_t m_input_last_state;
     RotaryMode m_mode;
+    bool m_use_interrupt;
+    port_reg_t *m_dat_port;
+    port_reg_t *m_clk_port;
+    uint32_t m_dat_mask;
+    uint32_t m_clk_mask;
+    RingBuffer<encoder_event, ENCODER_EVENTS> m_events;
+
+    uint8_t sample(void);
+    uint8_t step(uint8_t pins);
 
     uint32_t m_last_changed_time;
     bool m_change_expired;
@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include <string.h>
+#include "settings.h"
+#include "telemetryProtocol.h"
+
+/* Explicit little endian layout, the struct itself is never stored */
+static void encode_record(const settings &values, uint32_t sequence, uint8_t *record) {
+    memset(record, 0xFF, SETTINGS_RECORD_BYTES);
+    record[0] = cSETTINGS_MAGIC;
+    record[1] = cSETTINGS_VERSION;
+    record[2] = static_cast<uint8_t>(sequence);
+    record[3] = static_cast<uint8_t>(sequence >> 8);
+    record[4] = static_cast<uint8_t>(sequence >> 16);
+    record[5] = static_cast<uint8_t>(sequence >> 24);
+    record[6] = values.warmup;
+    record[7] = values.race_length_index;
+    record[8] = values.race_length;
+    record[9] = values.custom_race_length;
+    record[10] = values.laptime;
+    record[11] = values.fuel_consumption;
+    record[12] = values.tank_capacity;
+    record[13] = values.pit_loss;
+    // Still erased in a record cut short, a CRC alone lets one in 256 of those pass
+    record[14] = 0x00;
+    record[SETTINGS_RECORD_BYTES - 1] = crc8(record, SETTINGS_RECORD_BYTES - 1);
+}
+
+static bool same_settings(const settings &a, const settings &b) {
+    return memcmp(&a, &b, sizeof(settings)) == 0;
+}
+
+bool SettingsStore::read_slot(uint16_t slot, settings &values, uint32_t &sequence) {
+    uint8_t record[SETTINGS_RECORD_BYTES];
+
+    flash_read(static_cast<uint32_t>(slot) * FLASH_WRITE_BYTES, record, sizeof(record));
+    if (record[0] != cSETTINGS_MAGIC || record[1] != cSETTINGS_VERSION || record[14] != 0x00 ||
+        crc8(record, SETTINGS_RECORD_BYTES - 1) != record[SETTINGS_RECORD_BYTES - 1]) {
+        return false;
+    }
+    sequence = static_cast<uint32_t>(record[2]) | static_cast<uint32_t>(record[3]) << 8 |
+               static_cast<uint32_t>(record[4]) << 16 | static_cast<uint32_t>(record[5]) << 24;
+    values.warmup = record[6];
+    values.race_length_index = record[7];
+    values.race_length = record[8];
+    values.custom_race_length = record[9];
+    values.laptime = record[10];
+    values.fuel_consumption = record[11];
+    values.tank_capacity = record[12];
+    values.pit_loss = record[13];
+    return true;
+}
+
+/* Only the record bytes are ever programmed, the rest of a unit stays erased */
+bool SettingsStore::slot_erased(uint16_t slot) {
+    uint8_t record[SETTINGS_RECORD_BYTES];
+
+    flash_read(static_cast<uint32_t>(slot) * FLASH_WRITE_BYTES, record, sizeof(record));
+    for (uint8_t i = 0; i < SETTINGS_RECORD_BYTES; ++i) {
+        if (record[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* One pass over the log, false leaves the defaults in values as they are */
+bool SettingsStore::load(settings &values) {
+    settings slot_values;
+    uint32_t sequence;
+    bool found = false;
+
+    // Nothing is written until the values differ from what load() returns
+    m_saved = values;
+    m_values = values;
+    m_stats.scan_slots = 0;
+    if (!flash_available()) {
+        return false;
+    }
+    for (uint16_t slot = 0; slot < SETTINGS_SLOTS; ++slot) {
+        m_stats.scan_slots++;
+        if (read_slot(slot, slot_values, sequence) && (!found || sequence > m_sequence)) {
+            found = true;
+            m_sequence = sequence;
+            m_next = (slot + 1U) % SETTINGS_SLOTS;
+            values = slot_values;
+        }
+    }
+    if (found) {
+        m_saved = values;
+        m_values = values;
+    }
+    return found;
+}
+
+/* Remember the values, they are written once the encoder has been quiet */
+void SettingsStore::update(const settings &values, uint32_t now_ms) {
+    if (same_settings(values, m_values)) {
+        return;
+    }
+    m_values = values;
+    m_changed_ms = now_ms;
+    m_pending = true;
+}
+
+/* Call when idle, true if a record was written */
+bool SettingsStore::service(uint32_t now_ms) {
+    if (!m_pending || now_ms - m_changed_ms < cSETTINGS_IDLE_MS) {
+        return false;
+    }
+    m_pending = false;
+    if (same_settings(m_values, m_saved)) {
+        m_stats.skipped++;
+        return false;
+    }
+    if (!append(m_values)) {
+        m_stats.failures++;
+        return false;
+    }
+    m_saved = m_values;
+    return true;
+}
+
+/*
+ * Erase a block as the log enters it. Slots further in that aren't erased
+ * hold a torn record and are passed over until the next erase.
+ */
+bool SettingsStore::append(const settings &values) {
+    uint8_t record[SETTINGS_RECORD_BYTES];
+    settings check;
+    uint32_t sequence;
+
+    if (!flash_available()) {
+        return false;
+    }
+    for (uint16_t tries = 0; tries < SETTINGS_SLOTS; ++tries) {
+        uint16_t slot = m_next;
+        uint32_t offset = static_cast<uint32_t>(slot) * FLASH_WRITE_BYTES;
+
+        m_next = (slot + 1U) % SETTINGS_SLOTS;
+        if (offset % FLASH_BLOCK_BYTES == 0) {
+            if (!flash_erase(offset)) {
+                return false;
+            }
+            m_stats.erases++;
+        } else if (!slot_erased(slot)) {
+            continue;
+        }
+        encode_record(values, m_sequence + 1U, record);
+        if (!flash_write(offset, record, sizeof(record))) {
+            return false;
+        }
+        m_stats.writes++;
+        // Read back, a unit that didn't take the record is skipped
+        if (read_slot(slot, check, sequence) && sequence == m_sequence + 1U && same_settings(check, values)) {
+            m_sequence = sequence;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SettingsStore::pending(void) const {
+    return m_pending;
+}
+
+const settings_stats &SettingsStore::get_stats(void) const {
+    return m_stats;
+}
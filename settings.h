@@ -0,0 +1,65 @@
+#pragma once
+
+#include "stdint.h"
+#include "flash.h"
+
+#define SETTINGS_RECORD_BYTES   16
+#define SETTINGS_SLOTS          (FLASH_LOG_BYTES / FLASH_WRITE_BYTES)
+
+static constexpr uint8_t cSETTINGS_MAGIC = 0xF5U;
+static constexpr uint8_t cSETTINGS_VERSION = 1U;
+/* Encoder quiet time before the values go to flash */
+static constexpr uint32_t cSETTINGS_IDLE_MS = 3000U;
+
+static_assert(SETTINGS_RECORD_BYTES <= FLASH_WRITE_BYTES, "A record must fit in one write unit");
+static_assert(FLASH_LOG_BYTES / FLASH_BLOCK_BYTES >= 2, "Erasing a block must leave the newest record in another");
+
+/* Calculator inputs that survive a power cycle */
+struct settings {
+    uint8_t warmup;
+    uint8_t race_length_index;
+    uint8_t race_length;
+    uint8_t custom_race_length;
+    uint8_t laptime;
+    uint8_t fuel_consumption;
+    uint8_t tank_capacity;
+    uint8_t pit_loss;
+};
+
+struct settings_stats {
+    uint32_t writes;
+    uint32_t erases;
+    // Changes that were undone before the idle time ran out
+    uint32_t skipped;
+    uint32_t failures;
+    uint16_t scan_slots;
+};
+
+/*
+ * Append-only settings log. Every write unit holds one record with a
+ * sequence number and a CRC, the valid record with the highest sequence
+ * is current. Appending walks all slots in turn, so each block is erased
+ * once per pass over the log and wear is spread evenly. A record torn by
+ * a power cut fails its CRC and the previous one stays current.
+ */
+class SettingsStore {
+public:
+    bool load(settings &values);
+    void update(const settings &values, uint32_t now_ms);
+    bool service(uint32_t now_ms);
+    bool pending(void) const;
+    const settings_stats &get_stats(void) const;
+
+private:
+    bool read_slot(uint16_t slot, settings &values, uint32_t &sequence);
+    bool slot_erased(uint16_t slot);
+    bool append(const settings &values);
+
+    settings m_saved {};
+    settings m_values {};
+    uint32_t m_sequence {0};
+    uint16_t m_next {0};
+    bool m_pending {false};
+    uint32_t m_changed_ms {0};
+    settings_stats m_stats {};
+};
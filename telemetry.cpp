@@ -0,0 +1,222 @@
+#include <Arduino.h>
+#include "telemetry.h"
+
+bool Telemetry::is_tag(uint8_t byte) {
+    return byte == 'T' || byte == 'U' || byte == 'C' || byte == 'L';
+}
+
+/* Take what the UART has buffered without ever waiting for more */
+void Telemetry::poll(void) {
+    uint32_t now_us = micros();
+    int budget = TELEMETRY_RX_BUDGET;
+
+    // The watchdog runs on millis(), micros() / 1000 drifts from it on wrap
+    m_poll_ms = millis();
+
+    if ((m_state == State::Payload || (m_state == State::Binary && m_len > 0)) &&
+        now_us - m_start_us > cTELEMETRY_FRAME_TIMEOUT_US) {
+        m_stats.timeouts++;
+        m_state = State::Discard;
+    }
+
+    while (budget-- > 0 && Serial.available() > 0) {
+        feed(static_cast<uint8_t>(Serial.read()), now_us);
+    }
+}
+
+void Telemetry::feed(uint8_t byte, uint32_t now_us) {
+    switch (m_state) {
+        case State::Idle:
+            if (byte == 0x00) {
+                m_len = 0;
+                m_state = State::Binary;
+            } else if (is_tag(byte)) {
+                m_frame = m_frames.claim();
+                if (m_frame == nullptr) {
+                    m_stats.dropped++;
+                    m_state = State::Discard;
+                    break;
+                }
+                m_frame->tag = static_cast<char>(byte);
+                m_len = 0;
+                m_start_us = now_us;
+                m_state = State::Payload;
+            } else if (byte != ';' && byte != '\r' && byte != '\n') {
+                m_stats.unknown++;
+                m_state = State::Discard;
+            }
+            break;
+        case State::Payload:
+            if (byte == ';') {
+                m_frame->payload[m_len] = '\0';
+                m_frame->numeric = false;
+                m_frame->received_us = now_us;
+                m_frames.publish();
+                frame_done(now_us);
+                m_state = State::Idle;
+            } else if (byte == 0x00) {
+                // Unterminated text, the claimed frame is simply not published
+                m_stats.unknown++;
+                m_len = 0;
+                m_state = State::Binary;
+            } else if (m_len < TELEMETRY_PAYLOAD) {
+                m_frame->payload[m_len++] = static_cast<char>(byte);
+            } else {
+                m_stats.overflows++;
+                m_state = State::Discard;
+            }
+            break;
+        case State::Binary:
+            if (byte == 0x00) {
+                // Empty frames are skipped, after a bad one the delimiter
+                // most likely opened the next frame
+                if (m_len > 0) {
+                    if (binary_done(now_us)) {
+                        m_state = State::Closed;
+                    }
+                    m_len = 0;
+                }
+            } else if (m_len == 0 && byte > TELEMETRY_MAX_PACKET + 1) {
+                // Too long for a first COBS code, text follows the last frame
+                m_state = State::Idle;
+                feed(byte, now_us);
+            } else if (m_len < TELEMETRY_MAX_FRAME) {
+                if (m_len == 0) {
+                    m_start_us = now_us;
+                }
+                m_binary[m_len++] = byte;
+            } else {
+                m_stats.overflows++;
+                m_state = State::Discard;
+            }
+            break;
+        case State::Closed:
+            // A line break after a frame is text, so a frame starting with
+            // code 0x0a or 0x0d needs its own opening delimiter
+            if (byte == 0x00) {
+                m_state = State::Binary;
+            } else if (byte == '\r' || byte == '\n') {
+                m_state = State::Idle;
+            } else {
+                m_state = State::Binary;
+                feed(byte, now_us);
+            }
+            break;
+        case State::Discard:
+            // Resynchronise on the next terminator or binary delimiter
+            if (byte == ';') {
+                m_state = State::Idle;
+            } else if (byte == 0x00) {
+                m_len = 0;
+                m_state = State::Binary;
+            }
+            break;
+    }
+}
+
+void Telemetry::frame_done(uint32_t now_us) {
+    m_stats.frames++;
+    m_stats.last_latency_us = now_us - m_start_us;
+    if (m_stats.last_latency_us > m_stats.max_latency_us) {
+        m_stats.max_latency_us = m_stats.last_latency_us;
+    }
+    m_last_frame_ms = m_poll_ms;
+}
+
+/* Decode in place, a packet is never longer than its COBS block. True
+   when the frame held a packet, even one there was no room for */
+bool Telemetry::binary_done(uint32_t now_us) {
+    size_t len = cobs_decode(m_binary, m_len, m_binary);
+    fuel_packet fuel;
+    lap_packet lap;
+    blob_chunk chunk;
+
+    if (decode_fuel_packet(m_binary, len, fuel)) {
+        m_fuel = fuel;
+        push_value('U', fuel.fuel_per_lap, 2, now_us);
+        push_value('C', fuel.consumption, 2, now_us);
+        push_value('L', fuel.laps_remaining, 2, now_us);
+    } else if (decode_lap_packet(m_binary, len, lap)) {
+        // The frame only announces laps, next_lap() hands out the packets
+        if (!m_laps.push(lap)) {
+            m_stats.dropped++;
+            return true;
+        }
+        push_value('P', lap.lap, 0, now_us);
+    } else if (decode_chunk_packet(m_binary, len, chunk)) {
+        // Uploads are drained every loop, there is no frame for them
+        if (!m_chunks.push(chunk)) {
+            m_stats.dropped++;
+            return true;
+        }
+    } else {
+        m_stats.crc_errors++;
+        return false;
+    }
+    frame_done(now_us);
+    return true;
+}
+
+void Telemetry::push_value(char tag, uint16_t value, uint8_t decimals, uint32_t now_us) {
+    telemetry_frame *frame = m_frames.claim();
+
+    if (frame == nullptr) {
+        m_stats.dropped++;
+        return;
+    }
+    frame->tag = tag;
+    frame->payload[0] = '\0';
+    frame->numeric = true;
+    frame->value = value;
+    frame->decimals = decimals;
+    frame->received_us = now_us;
+    m_frames.publish();
+}
+
+telemetry_frame *Telemetry::front(void) {
+    return m_frames.front();
+}
+
+void Telemetry::release(void) {
+    m_frames.release();
+}
+
+TelemetryLink Telemetry::link(void) const {
+    return m_link;
+}
+
+/* Watchdog, returns true when the link went online or offline */
+bool Telemetry::check_link(uint32_t now_ms) {
+    TelemetryLink link = m_link;
+
+    if (m_stats.frames > 0) {
+        link = (now_ms - m_last_frame_ms > cTELEMETRY_TIMEOUT_MS) ? TelemetryLink::Offline : TelemetryLink::Online;
+    } else if (now_ms > cTELEMETRY_TIMEOUT_MS) {
+        link = TelemetryLink::Offline;
+    }
+
+    if (link != m_link) {
+        m_link = link;
+        return true;
+    }
+    return false;
+}
+
+const telemetry_stats &Telemetry::get_stats(void) const {
+    return m_stats;
+}
+
+/* Latest binary fuel packet, all zero until one arrives */
+const fuel_packet &Telemetry::fuel(void) const {
+    return m_fuel;
+}
+
+/* Completed laps in order, each 'P' frame has one behind it */
+bool Telemetry::next_lap(lap_packet &lap) {
+    return m_laps.pop(lap);
+}
+
+/* Blob upload chunks in the order they arrived */
+bool Telemetry::next_chunk(blob_chunk &chunk) {
+    return m_chunks.pop(chunk);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "stdint.h"
+#include "ringBuffer.h"
+#include "telemetryProtocol.h"
+
+#define TELEMETRY_PAYLOAD       12
+#define TELEMETRY_FRAMES        8
+/* Bytes taken from the UART per poll() so a burst can't stall the loop */
+#define TELEMETRY_RX_BUDGET     32
+
+static constexpr uint32_t cTELEMETRY_TIMEOUT_MS = 5000U;
+static constexpr uint32_t cTELEMETRY_FRAME_TIMEOUT_US = 100000U;
+
+enum class TelemetryLink {
+    Waiting,
+    Online,
+    Offline
+};
+
+struct telemetry_frame {
+    char tag;
+    char payload[TELEMETRY_PAYLOAD + 1];
+    /* Binary frames carry a number instead of the payload text */
+    bool numeric;
+    int32_t value;
+    uint8_t decimals;
+    uint32_t received_us;
+};
+
+struct telemetry_stats {
+    uint32_t frames;
+    uint16_t overflows;
+    uint16_t unknown;
+    uint16_t timeouts;
+    uint16_t dropped;
+    uint16_t crc_errors;
+    uint32_t last_latency_us;
+    uint32_t max_latency_us;
+};
+
+/*
+ * Incremental parser for SimHub messages, a tag followed by the payload
+ * and ';'. Payloads are written straight into the frame ring. A 0x00 byte
+ * starts a binary frame instead, see telemetryProtocol.h.
+ */
+class Telemetry {
+public:
+    void poll(void);
+    void feed(uint8_t byte, uint32_t now_us);
+    telemetry_frame *front(void);
+    void release(void);
+    TelemetryLink link(void) const;
+    bool check_link(uint32_t now_ms);
+    const telemetry_stats &get_stats(void) const;
+    const fuel_packet &fuel(void) const;
+    bool next_lap(lap_packet &lap);
+    bool next_chunk(blob_chunk &chunk);
+
+private:
+    enum class State {
+        Idle,
+        Payload,
+        Binary,
+        // After a binary frame, its delimiter may also open the next one
+        Closed,
+        Discard
+    };
+
+    static bool is_tag(uint8_t byte);
+    void frame_done(uint32_t now_us);
+    bool binary_done(uint32_t now_us);
+    void push_value(char tag, uint16_t value, uint8_t decimals, uint32_t now_us);
+
+    RingBuffer<telemetry_frame, TELEMETRY_FRAMES> m_frames;
+    telemetry_frame *m_frame {nullptr};
+    State m_state {State::Idle};
+    uint8_t m_len {0};
+    uint8_t m_binary[TELEMETRY_MAX_FRAME];
+    fuel_packet m_fuel {};
+    RingBuffer<lap_packet, TELEMETRY_FRAMES> m_laps;
+    RingBuffer<blob_chunk, TELEMETRY_FRAMES> m_chunks;
+    uint32_t m_start_us {0};
+    uint32_t m_poll_ms {0};
+    uint32_t m_last_frame_ms {0};
+    TelemetryLink m_link {TelemetryLink::Waiting};
+    telemetry_stats m_stats {};
+};
@@ -0,0 +1,164 @@
+#include <string.h>
+#include "telemetryProtocol.h"
+
+/* CRC-8, polynomial 0x07 */
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc) {
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* Consistent overhead byte stuffing, out needs len + len / 254 + 1 bytes */
+size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code_pos = 0;
+    size_t out_len = 1;
+    uint8_t code = 0x01;
+
+    for (size_t i = 0; i < len; ++i) {
+        if (in[i] == 0x00) {
+            out[code_pos] = code;
+            code_pos = out_len++;
+            code = 0x01;
+        } else {
+            out[out_len++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = out_len++;
+                code = 0x01;
+            }
+        }
+    }
+    out[code_pos] = code;
+    return out_len;
+}
+
+/* Returns the decoded length, 0 for a malformed block */
+size_t cobs_decode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t out_len = 0;
+    size_t i = 0;
+
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0x00 || i + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t j = 1; j < code; ++j) {
+            if (in[i] == 0x00) {
+                return 0;
+            }
+            out[out_len++] = in[i++];
+        }
+        if (code != 0xFF && i < len) {
+            out[out_len++] = 0x00;
+        }
+    }
+    return out_len;
+}
+
+static void put_u16(uint8_t *p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+/* Add the CRC, the last byte of raw, and frame it with both delimiters, returns the frame length */
+static size_t frame_packet(uint8_t *raw, size_t len, uint8_t *frame) {
+    raw[len - 1] = crc8(raw, len - 1);
+
+    frame[0] = 0x00;
+    len = cobs_encode(raw, len, &frame[1]);
+    frame[1 + len] = 0x00;
+    return len + 2;
+}
+
+static bool check_packet(const uint8_t *packet, size_t len, uint8_t type, size_t expected) {
+    return len == expected && packet[0] == type && crc8(packet, len - 1) == packet[len - 1];
+}
+
+size_t encode_fuel_frame(const fuel_packet &packet, uint8_t *frame) {
+    uint8_t raw[cFUEL_PACKET_LEN];
+
+    raw[0] = TELEMETRY_PACKET_FUEL;
+    put_u16(&raw[1], packet.fuel_remaining);
+    put_u16(&raw[3], packet.fuel_per_lap);
+    put_u16(&raw[5], packet.consumption);
+    put_u16(&raw[7], packet.laps_remaining);
+    return frame_packet(raw, sizeof(raw), frame);
+}
+
+bool decode_fuel_packet(const uint8_t *packet, size_t len, fuel_packet &out) {
+    if (!check_packet(packet, len, TELEMETRY_PACKET_FUEL, cFUEL_PACKET_LEN)) {
+        return false;
+    }
+
+    out.fuel_remaining = get_u16(&packet[1]);
+    out.fuel_per_lap = get_u16(&packet[3]);
+    out.consumption = get_u16(&packet[5]);
+    out.laps_remaining = get_u16(&packet[7]);
+    return true;
+}
+
+size_t encode_lap_frame(const lap_packet &packet, uint8_t *frame) {
+    uint8_t raw[cLAP_PACKET_LEN];
+
+    raw[0] = TELEMETRY_PACKET_LAP;
+    put_u16(&raw[1], packet.lap);
+    put_u16(&raw[3], packet.fuel_used);
+    put_u16(&raw[5], packet.laptime);
+    return frame_packet(raw, sizeof(raw), frame);
+}
+
+bool decode_lap_packet(const uint8_t *packet, size_t len, lap_packet &out) {
+    if (!check_packet(packet, len, TELEMETRY_PACKET_LAP, cLAP_PACKET_LEN)) {
+        return false;
+    }
+
+    out.lap = get_u16(&packet[1]);
+    out.fuel_used = get_u16(&packet[3]);
+    out.laptime = get_u16(&packet[5]);
+    return true;
+}
+
+size_t encode_chunk_frame(const blob_chunk &chunk, uint8_t *frame) {
+    uint8_t raw[cCHUNK_HEADER_LEN + TELEMETRY_CHUNK_BYTES + 1];
+    size_t len = chunk.len > TELEMETRY_CHUNK_BYTES ? TELEMETRY_CHUNK_BYTES : chunk.len;
+
+    raw[0] = TELEMETRY_PACKET_CHUNK;
+    put_u16(&raw[1], chunk.offset);
+    memcpy(&raw[cCHUNK_HEADER_LEN], chunk.data, len);
+    return frame_packet(raw, cCHUNK_HEADER_LEN + len + 1, frame);
+}
+
+/* The only packet without a fixed length, 1 to TELEMETRY_CHUNK_BYTES of data */
+bool decode_chunk_packet(const uint8_t *packet, size_t len, blob_chunk &out) {
+    if (len <= cCHUNK_HEADER_LEN + 1 || len > cCHUNK_HEADER_LEN + TELEMETRY_CHUNK_BYTES + 1 ||
+        !check_packet(packet, len, TELEMETRY_PACKET_CHUNK, len)) {
+        return false;
+    }
+
+    out.offset = get_u16(&packet[1]);
+    out.len = static_cast<uint8_t>(len - cCHUNK_HEADER_LEN - 1);
+    memcpy(out.data, &packet[cCHUNK_HEADER_LEN], out.len);
+    return true;
+}
+
+/* Consecutive chunk frames for a whole blob, returns their total length */
+size_t encode_blob_frames(const uint8_t *blob, size_t len, uint8_t *frames) {
+    blob_chunk chunk;
+    size_t frames_len = 0;
+
+    for (size_t offset = 0; offset < len; offset += chunk.len) {
+        chunk.offset = static_cast<uint16_t>(offset);
+        chunk.len = static_cast<uint8_t>(len - offset < TELEMETRY_CHUNK_BYTES ? len - offset : TELEMETRY_CHUNK_BYTES);
+        memcpy(chunk.data, &blob[offset], chunk.len);
+        frames_len += encode_chunk_frame(chunk, &frames[frames_len]);
+    }
+    return frames_len;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary telemetry frames: 0x00, COBS encoded packet, 0x00. A packet is a
+ * type byte, the little-endian payload and a CRC-8 over both.
+ *
+ * Back to back frames may share a delimiter, unless the first COBS code
+ * is 0x0a or 0x0d: after a frame those are a line break before text.
+ *
+ * A fuel update is 12 bytes back to back for four values, about 2x less
+ * per value than the text frames and short of the 3x once aimed for. The
+ * framing and CRC dominate at this size, fuelmeter_protocol measures it.
+ */
+#define TELEMETRY_PACKET_FUEL   0x01
+#define TELEMETRY_PACKET_LAP    0x02
+#define TELEMETRY_PACKET_CHUNK  0x03
+#define TELEMETRY_MAX_PACKET    32
+/* Blob bytes per chunk packet, a blob is sent as consecutive chunks */
+#define TELEMETRY_CHUNK_BYTES   16
+#define TELEMETRY_MAX_FRAME     (TELEMETRY_MAX_PACKET + TELEMETRY_MAX_PACKET / 254 + 3)
+/* Wire bytes for a whole blob at most, with both delimiters on every frame */
+#define TELEMETRY_BLOB_FRAMES_BYTES(len) \
+    (((len) + TELEMETRY_CHUNK_BYTES - 1) / TELEMETRY_CHUNK_BYTES * (TELEMETRY_MAX_FRAME + 2))
+
+struct fuel_packet {
+    uint16_t fuel_remaining;    // 0.01 l
+    uint16_t fuel_per_lap;      // 0.01 l, last lap
+    uint16_t consumption;       // 0.01 l per lap, average
+    uint16_t laps_remaining;    // 0.01 laps
+};
+
+/* Sent once per completed lap */
+struct lap_packet {
+    uint16_t lap;               // laps completed in the session
+    uint16_t fuel_used;         // 0.01 l
+    uint16_t laptime;           // 0.01 s
+};
+
+/* Part of a profile table upload, see profiles.h */
+struct blob_chunk {
+    uint16_t offset;            // of the first byte in the blob
+    uint8_t len;
+    uint8_t data[TELEMETRY_CHUNK_BYTES];
+};
+
+static constexpr size_t cFUEL_PACKET_LEN = 1 + 4 * sizeof(uint16_t) + 1;
+static constexpr size_t cLAP_PACKET_LEN = 1 + 3 * sizeof(uint16_t) + 1;
+static constexpr size_t cCHUNK_HEADER_LEN = 1 + sizeof(uint16_t);
+
+static_assert(cCHUNK_HEADER_LEN + TELEMETRY_CHUNK_BYTES + 1 <= TELEMETRY_MAX_PACKET, "A chunk must fit in a packet");
+
+/* Pass the previous result as crc to continue over more data */
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc = 0x00);
+size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+size_t cobs_decode(const uint8_t *in, size_t len, uint8_t *out);
+size_t encode_fuel_frame(const fuel_packet &packet, uint8_t *frame);
+bool decode_fuel_packet(const uint8_t *packet, size_t len, fuel_packet &out);
+size_t encode_lap_frame(const lap_packet &packet, uint8_t *frame);
+bool decode_lap_packet(const uint8_t *packet, size_t len, lap_packet &out);
+size_t encode_chunk_frame(const blob_chunk &chunk, uint8_t *frame);
+bool decode_chunk_packet(const uint8_t *packet, size_t len, blob_chunk &out);
+size_t encode_blob_frames(const uint8_t *blob, size_t len, uint8_t *frames);
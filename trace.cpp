@@ -0,0 +1,52 @@
+#include <Arduino.h>
+#include "trace.h"
+
+#if TRACE_LEVEL > TRACE_OFF
+
+#include "ringBuffer.h"
+
+struct trace_record {
+    uint32_t time_us;
+    int32_t value;
+    TraceId id;
+};
+
+static RingBuffer<trace_record, TRACE_RECORDS> records;
+static uint16_t reported_drops;
+
+/* Main loop only, the ring has a single producer */
+void trace_event(TraceId id, int32_t value) {
+    trace_record record = {micros(), value, id};
+
+    records.push(record);
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    p[2] = static_cast<uint8_t>(value >> 16);
+    p[3] = static_cast<uint8_t>(value >> 24);
+}
+
+/* Send whole records while the UART can take them without blocking */
+void trace_drain(void) {
+    trace_record *record;
+    uint8_t buf[TRACE_RECORD_BYTES];
+
+    while ((record = records.front()) != nullptr && Serial.availableForWrite() >= TRACE_RECORD_BYTES) {
+        buf[0] = TRACE_SYNC;
+        buf[1] = static_cast<uint8_t>(record->id);
+        put_u32(&buf[2], record->time_us);
+        put_u32(&buf[6], static_cast<uint32_t>(record->value));
+        Serial.write(buf, sizeof(buf));
+        records.release();
+    }
+
+    // Lost records are reported once the ring has room again
+    if (records.dropped() != reported_drops && records.count() < TRACE_RECORDS) {
+        reported_drops = records.dropped();
+        trace_event(TraceId::TraceDropped, reported_drops);
+    }
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "stdint.h"
+
+/*
+ * Compile-time trace levels. Calls above TRACE_LEVEL expand to nothing,
+ * their arguments are not evaluated. Records are queued in RAM and sent
+ * in binary by trace_drain() when the loop is idle, decode them on the
+ * host with fuelmeter_trace.
+ */
+#define TRACE_OFF               0
+#define TRACE_ERROR             1
+#define TRACE_INFO              2
+#define TRACE_DEBUG             3
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL             TRACE_OFF
+#endif
+
+#define TRACE_RECORDS           32
+#define TRACE_SYNC              0xA5
+#define TRACE_RECORD_BYTES      10
+
+/* Trace points, the host decoder prints these names */
+#define TRACE_IDS(X) \
+    X(RaceLengthDiff) \
+    X(RaceLengthIndex) \
+    X(Laps) \
+    X(FuelNeeded) \
+    X(InputLatency) \
+    X(AwakePermille) \
+    X(TraceDropped) \
+    X(LiveFuelNeeded) \
+    X(SettingsWrites) \
+    X(Profiles)
+
+enum class TraceId : uint8_t {
+#define TRACE_ID_ENUM(name) name,
+    TRACE_IDS(TRACE_ID_ENUM)
+#undef TRACE_ID_ENUM
+    Count
+};
+
+#if TRACE_LEVEL > TRACE_OFF
+void trace_event(TraceId id, int32_t value);
+void trace_drain(void);
+#else
+static inline void trace_drain(void) {}
+#endif
+
+#if TRACE_LEVEL >= TRACE_ERROR
+#define TRACE_E(id, value) trace_event(TraceId::id, (value))
+#else
+#define TRACE_E(id, value) do {} while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_INFO
+#define TRACE_I(id, value) trace_event(TraceId::id, (value))
+#else
+#define TRACE_I(id, value) do {} while (0)
+#endif
+
+#if TRACE_LEVEL >= TRACE_DEBUG
+#define TRACE_D(id, value) trace_event(TraceId::id, (value))
+#else
+#define TRACE_D(id, value) do {} while (0)
+#endif
@@ -0,0 +1,193 @@
+#include <string.h>
+#include "widgets.h"
+
+/* Bar columns: end caps, filled and empty, one pixel inside the page */
+static constexpr uint8_t cBAR_CAP = 0x7E;
+static constexpr uint8_t cBAR_FULL = 0x7E;
+static constexpr uint8_t cBAR_EMPTY = 0x42;
+
+int8_t Dashboard::add(WidgetType type, uint8_t page, uint8_t col, uint8_t width, FontSize size) {
+    widget *w;
+
+    if(m_count == WIDGETS_MAX) {
+        return -1;
+    }
+
+    w = &m_widgets[m_count];
+    memset(w, 0, sizeof(*w));
+    w->type = type;
+    w->size = size;
+    w->alignment = Alignment::Right;
+    w->page = page;
+    w->col = col;
+    w->width = width;
+    w->changed = true;
+
+    return m_count++;
+}
+
+int8_t Dashboard::add_text(uint8_t page, uint8_t col, uint8_t chars, FontSize size, Alignment alignment) {
+    int8_t id;
+
+    if(chars > WIDGET_TEXT) {
+        return -1;
+    }
+    id = add(WidgetType::Text, page, col, chars, size);
+    if(id >= 0) {
+        m_widgets[id].alignment = alignment;
+    }
+
+    return id;
+}
+
+int8_t Dashboard::add_number(uint8_t page, uint8_t col, uint8_t chars, FontSize size, uint8_t decimals) {
+    int8_t id;
+
+    if(chars > WIDGET_TEXT) {
+        return -1;
+    }
+    id = add(WidgetType::Number, page, col, chars, size);
+    if(id >= 0) {
+        m_widgets[id].decimals = decimals;
+    }
+
+    return id;
+}
+
+int8_t Dashboard::add_bar(uint8_t page, uint8_t col, uint8_t width, int32_t max) {
+    int8_t id = add(WidgetType::Bar, page, col, width, FontSize::Single);
+
+    if(id >= 0) {
+        m_widgets[id].max = max;
+    }
+
+    return id;
+}
+
+void Dashboard::set_text(int8_t id, const char *text) {
+    widget *w;
+
+    if(id < 0 || id >= m_count) {
+        return;
+    }
+
+    w = &m_widgets[id];
+    if(strncmp(w->text, text, WIDGET_TEXT) != 0) {
+        strncpy(w->text, text, WIDGET_TEXT);
+        w->changed = true;
+    }
+}
+
+void Dashboard::set_number(int8_t id, int32_t value) {
+    if(id < 0 || id >= m_count || m_widgets[id].value == value) {
+        return;
+    }
+
+    m_widgets[id].value = value;
+    m_widgets[id].changed = true;
+}
+
+void Dashboard::set_bar(int8_t id, int32_t value, int32_t max) {
+    if(id < 0 || id >= m_count || (m_widgets[id].value == value && m_widgets[id].max == max)) {
+        return;
+    }
+
+    m_widgets[id].value = value;
+    m_widgets[id].max = max;
+    m_widgets[id].changed = true;
+}
+
+/* Draw everything again, after the display was cleared */
+void Dashboard::invalidate(void) {
+    for(uint8_t i = 0; i < m_count; ++i) {
+        m_widgets[i].changed = true;
+    }
+}
+
+/* Text padded to the widget width with spaces, or cut to it */
+void Dashboard::render_text(uint8_t *data, const widget &w, const char *text) {
+    char line[WIDGET_TEXT + 1];
+    uint8_t len = strlen(text);
+    uint8_t fill;
+
+    if(len > w.width) {
+        len = w.width;
+    }
+    fill = w.width - len;
+    if(w.alignment == Alignment::Left) {
+        fill = 0;
+    } else if(w.alignment == Alignment::Center) {
+        fill /= 2;
+    }
+
+    memset(line, ' ', w.width);
+    memcpy(&line[fill], text, len);
+    line[w.width] = '\0';
+
+    set_cursor(w.page, w.col);
+    print_font(data, w.size, line);
+}
+
+/* Decimals are dropped until the number fits, dashes when even that is too wide */
+void Dashboard::render_number(uint8_t *data, const widget &w) {
+    char str[WIDGET_TEXT + 1];
+    int32_t value = w.value;
+    uint8_t decimals = w.decimals;
+
+    if(!format_value(str, value, decimals)) {
+        return;
+    }
+    while(strlen(str) > w.width && decimals > 0) {
+        value /= 10;
+        format_value(str, value, --decimals);
+    }
+    if(strlen(str) > w.width) {
+        memset(str, '-', w.width);
+        str[w.width] = '\0';
+    }
+
+    render_text(data, w, str);
+}
+
+void Dashboard::render_bar(uint8_t *data, const widget &w) {
+    int32_t value = w.value < 0 ? 0 : (w.value > w.max ? w.max : w.value);
+    uint8_t inner = w.width - 2;
+    uint8_t filled = w.max > 0 ? static_cast<uint8_t>(value * inner / w.max) : 0;
+    uint8_t column;
+
+    for(uint8_t i = 0; i < w.width; ++i) {
+        if(i == 0 || i == w.width - 1) {
+            column = cBAR_CAP;
+        } else {
+            column = (i - 1 < filled) ? cBAR_FULL : cBAR_EMPTY;
+        }
+        put_column(data, w.page, w.col + i, column);
+    }
+}
+
+/* Draw changed widgets into the frame, returns true if any was drawn */
+bool Dashboard::render(uint8_t *data) {
+    bool drawn = false;
+
+    for(uint8_t i = 0; i < m_count; ++i) {
+        widget &w = m_widgets[i];
+        if(!w.changed) {
+            continue;
+        }
+        switch(w.type) {
+            case WidgetType::Text:
+                render_text(data, w, w.text);
+                break;
+            case WidgetType::Number:
+                render_number(data, w);
+                break;
+            case WidgetType::Bar:
+                render_bar(data, w);
+                break;
+        }
+        w.changed = false;
+        drawn = true;
+    }
+
+    return drawn;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "stdint.h"
+#include "display.h"
+
+#define WIDGETS_MAX         8
+#define WIDGET_TEXT         12
+
+enum class WidgetType : uint8_t {
+    Text,
+    Number,
+    Bar
+};
+
+/*
+ * A rectangle of the display: text and numbers are chars wide in their
+ * font size, a bar is width columns on one page.
+ */
+struct widget {
+    WidgetType type;
+    FontSize size;
+    Alignment alignment;
+    uint8_t page;
+    uint8_t col;
+    uint8_t width;
+    uint8_t decimals;
+    bool changed;
+    int32_t value;
+    int32_t max;
+    char text[WIDGET_TEXT + 1];
+};
+
+/*
+ * Retained widget layout. Setters only store the content, render() draws
+ * the widgets whose content changed since the last call.
+ */
+class Dashboard {
+public:
+    int8_t add_text(uint8_t page, uint8_t col, uint8_t chars, FontSize size, Alignment alignment = Alignment::Left);
+    int8_t add_number(uint8_t page, uint8_t col, uint8_t chars, FontSize size, uint8_t decimals);
+    int8_t add_bar(uint8_t page, uint8_t col, uint8_t width, int32_t max);
+    void set_text(int8_t id, const char *text);
+    void set_number(int8_t id, int32_t value);
+    void set_bar(int8_t id, int32_t value, int32_t max);
+    void invalidate(void);
+    bool render(uint8_t *data);
+
+private:
+    int8_t add(WidgetType type, uint8_t page, uint8_t col, uint8_t width, FontSize size);
+    void render_text(uint8_t *data, const widget &w, const char *text);
+    void render_number(uint8_t *data, const widget &w);
+    void render_bar(uint8_t *data, const widget &w);
+
+    widget m_widgets[WIDGETS_MAX];
+    uint8_t m_count {0};
+};